@@ -1,3 +1,7 @@
+#include <vector>
+
+#include "PaneLayout.hpp"
+
 // ¡
 class CloneWindow {
 public:
@@ -8,6 +12,9 @@ public:
         SetRectEmpty(&m_sourceClientRect);
         SetRectEmpty(&m_lastSourceClientRect);
         SetRectEmpty(&m_thumbnailRect);
+
+        //  0 ͼԴڣֱ
+        m_layout.AddPane(PaneSpec());
     }
 
     ~CloneWindow() {
@@ -17,6 +24,7 @@ public:
             DwmUnregisterThumbnail(m_hThumbnail);
             m_hThumbnail = 0;
         }
+        ReleasePaneThumbnails();
     }
 
     bool Create(HINSTANCE hInstance, int nCmdShow) {
@@ -46,13 +54,6 @@ public:
             return false;
         }
 
-        if (!InitializeThumbnail()) {
-            MessageBox(m_hMainWindow, L"޷ʼͼ", L"", MB_ICONERROR);
-            DestroyWindow(m_hMainWindow);
-            m_hMainWindow = 0;
-            return false;
-        }
-
         SIZE minSize = GetMinimumSuggestedSize();
         RECT rcWindow;
         GetWindowRect(m_hMainWindow, &rcWindow);
@@ -68,6 +69,15 @@ public:
 
         ShowWindow(m_hMainWindow, nCmdShow);
         UpdateWindow(m_hMainWindow);
+
+        // ʾڣעͼ
+        if (!InitializeThumbnail()) {
+            MessageBox(m_hMainWindow, L"޷ʼͼ", L"", MB_ICONERROR);
+            DestroyWindow(m_hMainWindow);
+            m_hMainWindow = 0;
+            return false;
+        }
+
         UpdateThumbnail();
 
         return true;
@@ -81,6 +91,40 @@ public:
         return m_hMainWindow;
     }
 
+    // 򴰸񣨷ŴСͼȣش
+    //  Create ֮ǰ֮
+    size_t AddPane(const PaneSpec& spec) {
+        size_t index = m_layout.AddPane(spec);
+        m_paneThumbnails.push_back(0);
+
+        if (m_hThumbnail) {
+            RegisterPaneThumbnail(index);
+            UpdateThumbnail();
+        }
+        return index;
+    }
+
+    bool SetPane(size_t index, const PaneSpec& spec) {
+        if (!m_layout.SetPane(index, spec)) return false;
+
+        if (m_hThumbnail) UpdateThumbnail();
+        return true;
+    }
+
+    size_t GetPaneCount() const {
+        return m_layout.GetPaneCount();
+    }
+
+    // ӳ䣺Դڿͻ <-> ¡ڿͻ
+    bool GetPaneMapping(size_t index, PaneMapping* mapping) const {
+        return m_layout.GetMapping(index, mapping);
+    }
+
+    // ڵӲе任Ӳ㸲Ǵ 0 OverlayWindow::SetPaneSpace ʹ
+    bool GetPaneTransform(size_t index, PaneTransform* transform) const {
+        return m_layout.GetOverlayTransform(index, transform);
+    }
+
     int Run() {
         MSG msg = { 0 };
         while (GetMessage(&msg, 0, 0, 0)) {
@@ -169,6 +213,41 @@ private:
     RECT m_lastSourceClientRect;
     RECT m_thumbnailRect;
 
+    // 򴰸m_paneThumbnails[i] Ӧ i + 1
+    PaneLayout m_layout;
+    std::vector<HTHUMBNAIL> m_paneThumbnails;
+
+    HTHUMBNAIL GetPaneThumbnail(size_t index) const {
+        if (index == 0) return m_hThumbnail;
+        return index - 1 < m_paneThumbnails.size() ? m_paneThumbnails[index - 1] : 0;
+    }
+
+    bool RegisterPaneThumbnail(size_t index) {
+        if (index == 0 || index - 1 >= m_paneThumbnails.size()) return false;
+
+        HTHUMBNAIL& hThumbnail = m_paneThumbnails[index - 1];
+        if (!hThumbnail && FAILED(DwmRegisterThumbnail(m_hMainWindow, m_hSourceWindow, &hThumbnail))) {
+            hThumbnail = 0;
+            return false;
+        }
+
+        m_layout.Invalidate(index);
+        return true;
+    }
+
+    void ReleasePaneThumbnails() {
+        for (HTHUMBNAIL& hThumbnail : m_paneThumbnails) {
+            if (hThumbnail) {
+                DwmUnregisterThumbnail(hThumbnail);
+                hThumbnail = 0;
+            }
+        }
+    }
+
+    static RECT ToRect(const PaneRect& rect) {
+        return { rect.left, rect.top, rect.right, rect.bottom };
+    }
+
     bool InitializeThumbnail() {
         HRESULT hr = DwmRegisterThumbnail(m_hMainWindow, m_hSourceWindow, &m_hThumbnail);
         if (FAILED(hr)) {
@@ -182,6 +261,13 @@ private:
         }
 
         m_lastSourceClientRect = m_sourceClientRect;
+
+        // עʧܵӴʾӰͼ
+        for (size_t index = 1; index < m_layout.GetPaneCount(); ++index) {
+            RegisterPaneThumbnail(index);
+        }
+        m_layout.Invalidate(0);
+
         SetTimer(m_hMainWindow, 1001, 500, 0);
         return true;
     }
@@ -206,35 +292,30 @@ private:
         if (srcWidth <= 0 || srcHeight <= 0)
             return false;
 
-        float srcAspectRatio = (float)srcWidth / srcHeight;
-        float clientAspectRatio = (float)clientWidth / clientHeight;
-
-        int dstWidth, dstHeight;
-        if (srcAspectRatio > clientAspectRatio) {
-            dstWidth = clientWidth;
-            dstHeight = (int)(dstWidth / srcAspectRatio);
-        }
-        else {
-            dstHeight = clientHeight;
-            dstWidth = (int)(dstHeight * srcAspectRatio);
-        }
-
-        int x = (clientWidth - dstWidth) / 2;
-        int y = (clientHeight - dstHeight) / 2;
-
-        m_thumbnailRect.left = x;
-        m_thumbnailRect.top = y;
-        m_thumbnailRect.right = x + dstWidth;
-        m_thumbnailRect.bottom = y + dstHeight;
-
-        DWM_THUMBNAIL_PROPERTIES props = { 0 };
-        props.dwFlags = DWM_TNP_VISIBLE | DWM_TNP_RECTDESTINATION | DWM_TNP_RECTSOURCE | DWM_TNP_OPACITY;
-        props.fVisible = TRUE;
-        props.opacity = 255;
-        props.rcSource = m_sourceClientRect;
-        props.rcDestination = { x, y, x + dstWidth, y + dstHeight };
-
-        return SUCCEEDED(DwmUpdateThumbnailProperties(m_hThumbnail, &props));
+        // һμдֻԼη仯Ĵ DwmUpdateThumbnailProperties
+        PaneRect sourceClient = {
+            (int)m_sourceClientRect.left, (int)m_sourceClientRect.top,
+            (int)m_sourceClientRect.right, (int)m_sourceClientRect.bottom };
+        bool mainUpdated = true;
+
+        m_layout.Update(sourceClient, clientWidth, clientHeight, [&](size_t index, const PaneGeometry& geometry) {
+            HTHUMBNAIL hThumbnail = GetPaneThumbnail(index);
+            if (!hThumbnail) return false;
+
+            DWM_THUMBNAIL_PROPERTIES props = { 0 };
+            props.dwFlags = DWM_TNP_VISIBLE | DWM_TNP_RECTDESTINATION | DWM_TNP_RECTSOURCE | DWM_TNP_OPACITY;
+            props.fVisible = geometry.visible ? TRUE : FALSE;
+            props.opacity = geometry.opacity;
+            props.rcSource = ToRect(geometry.source);
+            props.rcDestination = ToRect(geometry.destination);
+
+            bool updated = SUCCEEDED(DwmUpdateThumbnailProperties(hThumbnail, &props));
+            if (index == 0) mainUpdated = updated;
+            return updated;
+        });
+
+        m_thumbnailRect = ToRect(m_layout.GetGeometry(0).destination);
+        return mainUpdated;
     }
 
     bool CheckSourceSizeChanged() {
@@ -388,6 +469,7 @@ private:
                 DwmUnregisterThumbnail(m_hThumbnail);
                 m_hThumbnail = 0;
             }
+            ReleasePaneThumbnails();
             PostQuitMessage(0);
             break;
 
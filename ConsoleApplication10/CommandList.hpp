@@ -0,0 +1,324 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "FrameDelta.hpp"
+
+// Draw commands recorded by one draw job, in overlay pixel coordinates.
+//
+// Every command carries the z-order key current when it was recorded (SetZ). Record
+// methods return the primitive so callers can set an id (for FrameDeltaEncoder) or flags
+// such as kSceneFlagLowPriority. Colors are 0xRRGGBBAA, see Rgba().
+class CommandList {
+public:
+    CommandList() : m_count(0), m_z(0) {}
+
+    static uint32_t Rgba(float r, float g, float b, float a = 1.0f) {
+        auto channel = [](float value) { return (uint32_t)((value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value)) * 255.0f + 0.5f); };
+        return (channel(r) << 24) | (channel(g) << 16) | (channel(b) << 8) | channel(a);
+    }
+
+    void SetZ(int32_t z) { m_z = z; }
+    int32_t GetZ() const { return m_z; }
+
+    OverlayPrimitive& DrawLine(float x0, float y0, float x1, float y1, float strokeWidth, uint32_t color) {
+        return Add(SceneElementType::Line, color, x0, y0, x1, y1, 0.0f, strokeWidth);
+    }
+
+    OverlayPrimitive& DrawSolidCircle(float x, float y, float radius, uint32_t color) {
+        return Add(SceneElementType::SolidCircle, color, x, y, x, y, radius, 0.0f);
+    }
+
+    OverlayPrimitive& DrawHollowCircle(float x, float y, float radius, float strokeWidth, uint32_t color) {
+        return Add(SceneElementType::HollowCircle, color, x, y, x, y, radius, strokeWidth);
+    }
+
+    OverlayPrimitive& DrawHollowDiamond(float x, float y, float radius, float strokeWidth, uint32_t color) {
+        return Add(SceneElementType::HollowDiamond, color, x, y, x, y, radius, strokeWidth);
+    }
+
+    OverlayPrimitive& DrawCornerBox(float left, float top, float right, float bottom, float strokeWidth, uint32_t color) {
+        return Add(SceneElementType::CornerBox, color, left, top, right, bottom, 0.0f, strokeWidth);
+    }
+
+    OverlayPrimitive& DrawSolidRectangle(float left, float top, float right, float bottom, uint32_t color) {
+        return Add(SceneElementType::SolidRectangle, color, left, top, right, bottom, 0.0f, 0.0f);
+    }
+
+    OverlayPrimitive& DrawHollowRectangle(float left, float top, float right, float bottom, float strokeWidth, uint32_t color) {
+        return Add(SceneElementType::HollowRectangle, color, left, top, right, bottom, 0.0f, strokeWidth);
+    }
+
+    OverlayPrimitive& DrawTextWithOutline(const wchar_t* text, float x, float y, float fontSize, uint32_t color) {
+        OverlayPrimitive& primitive = Add(SceneElementType::Text, color, x, y, x, y, fontSize, 0.0f);
+        primitive.text.assign(text ? text : L"");
+        return primitive;
+    }
+
+    OverlayPrimitive& Add(const OverlayPrimitive& primitive) {
+        OverlayPrimitive& added = Next();
+        added = primitive;
+        return added;
+    }
+
+    size_t GetCount() const { return m_count; }
+    const OverlayPrimitive& GetCommand(size_t index) const { return m_commands[index]; }
+    OverlayPrimitive& GetCommand(size_t index) { return m_commands[index]; }
+    int32_t GetCommandZ(size_t index) const { return m_keys[index]; }
+
+    // Keeps the storage (including text buffers) for the next frame
+    void Clear() {
+        m_count = 0;
+        m_z = 0;
+    }
+
+    // Stable sort by z key. Lists whose keys never decrease (the usual case) are left as is.
+    void SortByZ() {
+        bool sorted = true;
+        for (size_t i = 1; i < m_count && sorted; ++i) sorted = m_keys[i - 1] <= m_keys[i];
+        if (sorted) return;
+
+        m_order.resize(m_count);
+        for (size_t i = 0; i < m_count; ++i) m_order[i] = i;
+        std::stable_sort(m_order.begin(), m_order.end(), [this](size_t a, size_t b) { return m_keys[a] < m_keys[b]; });
+
+        std::vector<OverlayPrimitive> commands(m_count);
+        std::vector<int32_t> keys(m_count);
+        for (size_t i = 0; i < m_count; ++i) {
+            commands[i] = std::move(m_commands[m_order[i]]);
+            keys[i] = m_keys[m_order[i]];
+        }
+        std::move(commands.begin(), commands.end(), m_commands.begin());
+        std::copy(keys.begin(), keys.end(), m_keys.begin());
+    }
+
+private:
+    std::vector<OverlayPrimitive> m_commands;
+    std::vector<int32_t> m_keys;
+    std::vector<size_t> m_order; // SortByZ scratch
+    size_t m_count;
+    int32_t m_z;
+
+    OverlayPrimitive& Next() {
+        if (m_count == m_commands.size()) {
+            m_commands.emplace_back();
+            m_keys.push_back(0);
+        }
+
+        m_keys[m_count] = m_z;
+        return m_commands[m_count++];
+    }
+
+    OverlayPrimitive& Add(SceneElementType type, uint32_t color, float x0, float y0, float x1, float y1, float size, float stroke) {
+        OverlayPrimitive& primitive = Next();
+        primitive.id = 0;
+        primitive.type = (uint16_t)type;
+        primitive.flags = 0;
+        primitive.color = color;
+        primitive.x0 = x0;
+        primitive.y0 = y0;
+        primitive.x1 = x1;
+        primitive.y1 = y1;
+        primitive.size = size;
+        primitive.stroke = stroke;
+        primitive.text.clear();
+        return primitive;
+    }
+};
+
+// Runs draw jobs concurrently and merges what they recorded.
+//
+// Each job records into its own CommandList, so it does not matter which thread runs it.
+// The merged frame is ordered by z key, then job submission order, then recording order
+// within the job, which makes the output identical for any thread count or timing.
+class ParallelRecorder {
+public:
+    using Job = std::function<void(CommandList& list, int width, int height)>;
+
+    // threads counts the calling thread, which always takes part; 0 picks from the core count.
+    // Workers are started by the first Record() that has more than one job.
+    explicit ParallelRecorder(unsigned threads = 0)
+        : m_threads(threads ? threads : (std::min)((std::max)(std::thread::hardware_concurrency(), 1u), 8u)),
+        m_width(0),
+        m_height(0),
+        m_nextJob(0),
+        m_generation(0),
+        m_busyWorkers(0),
+        m_stopping(false) {
+    }
+
+    ~ParallelRecorder() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+
+        for (std::thread& worker : m_workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    ParallelRecorder(const ParallelRecorder&) = delete;
+    ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+    // z is the initial z key of the job's list. Jobs run every Record() until cleared.
+    size_t AddJob(Job job, int32_t z = 0) {
+        m_jobs.push_back({ std::move(job), z });
+        m_lists.emplace_back();
+        return m_jobs.size() - 1;
+    }
+
+    void ClearJobs() {
+        m_jobs.clear();
+        m_lists.clear();
+    }
+
+    size_t GetJobCount() const { return m_jobs.size(); }
+
+    unsigned GetThreadCount() const { return m_threads; }
+
+    // Runs every job and replaces out with the merged commands
+    void Record(int width, int height, std::vector<OverlayPrimitive>& out) {
+        out.clear();
+        if (m_jobs.empty()) return;
+
+        m_width = width;
+        m_height = height;
+        m_nextJob.store(0);
+
+        if (m_threads == 1 || m_jobs.size() == 1) {
+            RunJobs();
+        }
+        else {
+            while (m_workers.size() + 1 < m_threads) m_workers.emplace_back(&ParallelRecorder::WorkerLoop, this);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_busyWorkers = m_workers.size();
+                m_generation++;
+            }
+            m_wake.notify_all();
+
+            RunJobs();
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [this] { return m_busyWorkers == 0; });
+        }
+
+        Merge(out);
+    }
+
+private:
+    struct JobEntry {
+        Job job;
+        int32_t z;
+    };
+
+    std::vector<JobEntry> m_jobs;
+    std::vector<CommandList> m_lists;
+    std::vector<std::pair<int32_t, uint32_t>> m_order; // Sort scratch: (z, job)
+    std::vector<size_t> m_cursors;
+
+    unsigned m_threads;
+    int m_width;
+    int m_height;
+    std::atomic<size_t> m_nextJob;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::vector<std::thread> m_workers;
+    uint64_t m_generation;
+    size_t m_busyWorkers;
+    bool m_stopping;
+
+    // Jobs are handed out one at a time so long jobs do not leave other threads idle
+    void RunJobs() {
+        for (;;) {
+            size_t index = m_nextJob.fetch_add(1);
+            if (index >= m_jobs.size()) return;
+
+            CommandList& list = m_lists[index];
+            list.Clear();
+            list.SetZ(m_jobs[index].z);
+            if (m_jobs[index].job) m_jobs[index].job(list, m_width, m_height);
+        }
+    }
+
+    void WorkerLoop() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        for (;;) {
+            m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+            if (m_stopping) return;
+
+            seen = m_generation;
+            lock.unlock();
+            RunJobs();
+            lock.lock();
+
+            if (--m_busyWorkers == 0) m_idle.notify_one();
+        }
+    }
+
+    // Each list is put in (z, recording order) first, then the lists are merged by (z, job)
+    void Merge(std::vector<OverlayPrimitive>& out) {
+        size_t total = 0;
+        bool singleKey = true;
+        int32_t firstKey = m_lists[0].GetCount() ? m_lists[0].GetCommandZ(0) : 0;
+
+        for (CommandList& list : m_lists) {
+            total += list.GetCount();
+            list.SortByZ();
+            if (list.GetCount() && (list.GetCommandZ(0) != firstKey || list.GetCommandZ(list.GetCount() - 1) != firstKey)) singleKey = false;
+        }
+
+        out.reserve(total);
+
+        // Everything on one key: plain concatenation in job order
+        if (singleKey) {
+            for (CommandList& list : m_lists) {
+                for (size_t i = 0; i < list.GetCount(); ++i) out.push_back(list.GetCommand(i));
+            }
+            return;
+        }
+
+        // k-way merge; the (z, job) pair is unique per list head, so ties cannot occur
+        m_cursors.assign(m_lists.size(), 0);
+        m_order.clear();
+        auto later = [](const std::pair<int32_t, uint32_t>& a, const std::pair<int32_t, uint32_t>& b) { return a > b; };
+
+        for (uint32_t job = 0; job < (uint32_t)m_lists.size(); ++job) {
+            if (m_lists[job].GetCount()) m_order.push_back({ m_lists[job].GetCommandZ(0), job });
+        }
+        std::make_heap(m_order.begin(), m_order.end(), later);
+
+        while (!m_order.empty()) {
+            std::pop_heap(m_order.begin(), m_order.end(), later);
+            int32_t z = m_order.back().first;
+            uint32_t job = m_order.back().second;
+            m_order.pop_back();
+
+            // Take the whole run of this z from the list at once
+            CommandList& list = m_lists[job];
+            size_t& cursor = m_cursors[job];
+            while (cursor < list.GetCount() && list.GetCommandZ(cursor) == z) out.push_back(list.GetCommand(cursor++));
+
+            if (cursor < list.GetCount()) {
+                m_order.push_back({ list.GetCommandZ(cursor), job });
+                std::push_heap(m_order.begin(), m_order.end(), later);
+            }
+        }
+    }
+};
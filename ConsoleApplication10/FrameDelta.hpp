@@ -0,0 +1,477 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "OverlayScene.hpp"
+
+// One overlay primitive of a frame, in overlay pixel coordinates. Fields mean the same as
+// in SceneElement. id must be unique within a frame and stable across frames: it is what
+// the delta codec matches between consecutive frames.
+struct OverlayPrimitive {
+    uint32_t id = 0;
+    uint16_t type = 0;      // SceneElementType
+    uint16_t flags = 0;
+    uint32_t color = 0;     // 0xRRGGBBAA
+    float x0 = 0.0f, y0 = 0.0f;
+    float x1 = 0.0f, y1 = 0.0f;
+    float size = 0.0f;
+    float stroke = 0.0f;
+    std::wstring text;
+};
+
+// Frame delta codec
+//
+// Each encoded frame is one self-contained byte string:
+//
+//   varint frameFlags      kDeltaKeyframe, kDeltaSameLayout
+//   varint count           primitives in the frame
+//   tokens...              until count primitives are produced
+//
+// A token is a varint. With bit 0 set it is a run: the next (token >> 1) primitives are
+// unchanged copies of the reference primitives. Otherwise (token >> 1) is a field mask and
+// the changed fields follow in mask bit order:
+//
+//   kDeltaExplicitId   zigzag(id - (previous output id + 1))
+//   kDeltaTypeFlags    varint type | flags << 16
+//   kDeltaColor        varint color
+//   kDeltaX0 ... kDeltaStroke
+//                      zigzag(quantized value - quantized reference value)
+//   kDeltaText         varint length, then one varint per UTF-16 code unit
+//
+// Text is UTF-16 on the wire whatever the size of wchar_t. Where wchar_t is 32 bits,
+// code points above U+FFFF travel as surrogate pairs, and lone surrogates or values past
+// U+10FFFF are sent as U+FFFD.
+//
+// The reference of a primitive is, in a keyframe, an all-zero primitive. In a delta frame
+// the encoder walks the previous frame in order: a primitive whose id is the next one in
+// that walk refers to it implicitly, any other id is sent explicitly and refers to the
+// previous primitive with that id (or zero when it is new), and the walk continues after
+// it. Primitives of the previous frame that are never referred to are dropped.
+// kDeltaSameLayout marks a frame with the same ids in the same order as the previous one,
+// which the decoder applies in place.
+//
+// Coordinates, sizes and strokes are quantized to 1/kDeltaQuantization pixel and clamped
+// to +-kDeltaQuantizedLimit steps (NaN becomes 0). The encoder keeps the frame as the
+// decoder reconstructs it, so quantization error never accumulates.
+
+constexpr uint32_t kDeltaKeyframe = 0x01;
+constexpr uint32_t kDeltaSameLayout = 0x02;
+
+constexpr uint32_t kDeltaExplicitId = 1u << 0;
+constexpr uint32_t kDeltaTypeFlags = 1u << 1;
+constexpr uint32_t kDeltaColor = 1u << 2;
+constexpr uint32_t kDeltaX0 = 1u << 3;
+constexpr uint32_t kDeltaY0 = 1u << 4;
+constexpr uint32_t kDeltaX1 = 1u << 5;
+constexpr uint32_t kDeltaY1 = 1u << 6;
+constexpr uint32_t kDeltaSize = 1u << 7;
+constexpr uint32_t kDeltaStroke = 1u << 8;
+constexpr uint32_t kDeltaText = 1u << 9;
+
+constexpr float kDeltaQuantization = 8.0f;
+constexpr int32_t kDeltaQuantizedLimit = 1 << 29; // Differences of two values still fit in 31 bits
+constexpr uint32_t kDeltaCoordinateCount = 6;
+
+namespace FrameDelta {
+    inline void PutVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    inline bool GetVarint(const uint8_t*& data, const uint8_t* end, uint64_t* value) {
+        uint64_t result = 0;
+        for (int shift = 0; shift < 64 && data < end; shift += 7) {
+            uint8_t byte = *data++;
+            result |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                *value = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline uint64_t ZigZag(int64_t value) {
+        return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    }
+
+    inline int64_t UnZigZag(uint64_t value) {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    inline int32_t Quantize(float value) {
+        float scaled = value * kDeltaQuantization;
+        if (scaled != scaled) return 0;
+
+        scaled = (std::min)((std::max)(scaled, -(float)kDeltaQuantizedLimit), (float)kDeltaQuantizedLimit);
+        return (int32_t)std::lround(scaled);
+    }
+
+    inline float Dequantize(int64_t value) {
+        return (float)value / kDeltaQuantization;
+    }
+
+    inline float* Coordinate(OverlayPrimitive& primitive, uint32_t index) {
+        float* fields[kDeltaCoordinateCount] = { &primitive.x0, &primitive.y0, &primitive.x1, &primitive.y1, &primitive.size, &primitive.stroke };
+        return fields[index];
+    }
+
+    inline float GetCoordinate(const OverlayPrimitive& primitive, uint32_t index) {
+        return *Coordinate(const_cast<OverlayPrimitive&>(primitive), index);
+    }
+
+    // Where wchar_t holds code points, replaces what UTF-16 cannot carry with U+FFFD so the
+    // encoder's copy of the text matches what the decoder will rebuild
+    inline void SanitizeText(std::wstring& text) {
+        if constexpr (sizeof(wchar_t) > 2) {
+            for (wchar_t& c : text) {
+                uint32_t code = (uint32_t)c;
+                if ((code >= 0xD800 && code < 0xE000) || code > 0x10FFFF) c = (wchar_t)0xFFFD;
+            }
+        }
+    }
+
+    inline void ToUtf16(const std::wstring& text, std::u16string& units) {
+        units.clear();
+        for (wchar_t c : text) {
+            uint32_t code = (uint32_t)c;
+            if constexpr (sizeof(wchar_t) > 2) {
+                if (code > 0xFFFF) {
+                    code -= 0x10000;
+                    units.push_back((char16_t)(0xD800 + (code >> 10)));
+                    units.push_back((char16_t)(0xDC00 + (code & 0x3FF)));
+                    continue;
+                }
+            }
+            units.push_back((char16_t)code);
+        }
+    }
+
+    // Units are taken as they are where wchar_t is 16 bits; otherwise surrogate pairs are
+    // joined and lone surrogates become U+FFFD
+    inline void FromUtf16(const std::u16string& units, std::wstring& text) {
+        text.clear();
+        for (size_t i = 0; i < units.size(); ++i) {
+            uint32_t code = units[i];
+            if constexpr (sizeof(wchar_t) > 2) {
+                if (code >= 0xD800 && code < 0xE000) {
+                    if (code < 0xDC00 && i + 1 < units.size() && units[i + 1] >= 0xDC00 && units[i + 1] < 0xE000) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (units[++i] - 0xDC00);
+                    }
+                    else {
+                        code = 0xFFFD;
+                    }
+                }
+            }
+            text.push_back((wchar_t)code);
+        }
+    }
+
+    inline const OverlayPrimitive& ZeroPrimitive() {
+        static const OverlayPrimitive zero;
+        return zero;
+    }
+}
+
+class FrameDeltaEncoder {
+public:
+    // A keyframe is sent every keyframeInterval frames (0: only the first and forced ones)
+    explicit FrameDeltaEncoder(uint32_t keyframeInterval = 60)
+        : m_keyframeInterval(keyframeInterval),
+        m_framesSinceKeyframe(0),
+        m_forceKeyframe(true) {
+    }
+
+    // The next frame is a keyframe, e.g. when a new receiver joins
+    void ForceKeyframe() {
+        m_forceKeyframe = true;
+    }
+
+    // Appends the encoded frame to out; returns whether it was a keyframe
+    bool Encode(const std::vector<OverlayPrimitive>& frame, std::vector<uint8_t>& out) {
+        bool keyframe = m_forceKeyframe || (m_keyframeInterval && m_framesSinceKeyframe >= m_keyframeInterval);
+        bool sameLayout = !keyframe && SameLayout(frame);
+
+        uint32_t frameFlags = (keyframe ? kDeltaKeyframe : 0) | (sameLayout ? kDeltaSameLayout : 0);
+        FrameDelta::PutVarint(out, frameFlags);
+        FrameDelta::PutVarint(out, frame.size());
+
+        if (!keyframe && !sameLayout) IndexPrevious();
+
+        m_next.resize(frame.size());
+        size_t walk = 0;
+        uint64_t run = 0;
+        uint32_t lastId = (uint32_t)-1;
+
+        for (size_t i = 0; i < frame.size(); ++i) {
+            const OverlayPrimitive& primitive = frame[i];
+            const OverlayPrimitive* reference = &FrameDelta::ZeroPrimitive();
+            uint32_t mask = 0;
+
+            if (sameLayout) {
+                reference = &m_previous[i];
+            }
+            else if (keyframe) {
+                mask |= kDeltaExplicitId;
+            }
+            else if (walk < m_previous.size() && m_previous[walk].id == primitive.id) {
+                reference = &m_previous[walk++];
+            }
+            else {
+                mask |= kDeltaExplicitId;
+                auto found = m_previousIndex.find(primitive.id);
+                if (found != m_previousIndex.end()) {
+                    reference = &m_previous[found->second];
+                    walk = found->second + 1;
+                }
+            }
+
+            // The reconstructed primitive is what the decoder will hold
+            OverlayPrimitive& next = m_next[i];
+            next.id = primitive.id;
+            next.type = primitive.type;
+            next.flags = primitive.flags;
+            next.color = primitive.color;
+            next.text = primitive.text;
+            FrameDelta::SanitizeText(next.text);
+
+            int32_t deltas[kDeltaCoordinateCount];
+            for (uint32_t field = 0; field < kDeltaCoordinateCount; ++field) {
+                int32_t quantized = FrameDelta::Quantize(FrameDelta::GetCoordinate(primitive, field));
+                deltas[field] = quantized - FrameDelta::Quantize(FrameDelta::GetCoordinate(*reference, field));
+                *FrameDelta::Coordinate(next, field) = FrameDelta::Dequantize(quantized);
+                if (deltas[field]) mask |= kDeltaX0 << field;
+            }
+
+            if (primitive.type != reference->type || primitive.flags != reference->flags) mask |= kDeltaTypeFlags;
+            if (primitive.color != reference->color) mask |= kDeltaColor;
+            if (next.text != reference->text) mask |= kDeltaText;
+
+            if (!mask) {
+                run++;
+                lastId = primitive.id;
+                continue;
+            }
+
+            if (run) {
+                FrameDelta::PutVarint(out, run << 1 | 1);
+                run = 0;
+            }
+
+            FrameDelta::PutVarint(out, (uint64_t)mask << 1);
+            if (mask & kDeltaExplicitId) FrameDelta::PutVarint(out, FrameDelta::ZigZag((int64_t)primitive.id - ((int64_t)lastId + 1)));
+            if (mask & kDeltaTypeFlags) FrameDelta::PutVarint(out, (uint32_t)primitive.type | (uint32_t)primitive.flags << 16);
+            if (mask & kDeltaColor) FrameDelta::PutVarint(out, primitive.color);
+            for (uint32_t field = 0; field < kDeltaCoordinateCount; ++field) {
+                if (mask & (kDeltaX0 << field)) FrameDelta::PutVarint(out, FrameDelta::ZigZag(deltas[field]));
+            }
+            if (mask & kDeltaText) {
+                FrameDelta::ToUtf16(next.text, m_units);
+                FrameDelta::PutVarint(out, m_units.size());
+                for (char16_t unit : m_units) FrameDelta::PutVarint(out, unit);
+            }
+
+            lastId = primitive.id;
+        }
+
+        if (run) FrameDelta::PutVarint(out, run << 1 | 1);
+
+        m_previous.swap(m_next);
+        m_forceKeyframe = false;
+        m_framesSinceKeyframe = keyframe ? 1 : m_framesSinceKeyframe + 1;
+        return keyframe;
+    }
+
+private:
+    uint32_t m_keyframeInterval;
+    uint32_t m_framesSinceKeyframe;
+    bool m_forceKeyframe;
+    std::vector<OverlayPrimitive> m_previous;
+    std::vector<OverlayPrimitive> m_next;
+    std::unordered_map<uint32_t, size_t> m_previousIndex;
+    std::u16string m_units;
+
+    bool SameLayout(const std::vector<OverlayPrimitive>& frame) const {
+        if (frame.size() != m_previous.size()) return false;
+
+        for (size_t i = 0; i < frame.size(); ++i) {
+            if (frame[i].id != m_previous[i].id) return false;
+        }
+        return true;
+    }
+
+    // The first primitive with an id wins; the decoder indexes the same way
+    void IndexPrevious() {
+        m_previousIndex.clear();
+        for (size_t i = 0; i < m_previous.size(); ++i) m_previousIndex.emplace(m_previous[i].id, i);
+    }
+};
+
+class FrameDeltaDecoder {
+public:
+    FrameDeltaDecoder()
+        : m_valid(false) {
+    }
+
+    // Decodes one encoded frame, which must span exactly size bytes. Delta frames are
+    // rejected until a keyframe has been decoded, and again after any malformed frame.
+    bool Decode(const uint8_t* data, size_t size) {
+        const uint8_t* end = data + size;
+
+        uint64_t frameFlags, count;
+        if (!FrameDelta::GetVarint(data, end, &frameFlags) || !FrameDelta::GetVarint(data, end, &count)) return Fail();
+
+        if (frameFlags & ~(uint64_t)(kDeltaKeyframe | kDeltaSameLayout)) return Fail();
+
+        bool keyframe = (frameFlags & kDeltaKeyframe) != 0;
+        bool sameLayout = (frameFlags & kDeltaSameLayout) != 0;
+        if (!keyframe && !m_valid) return Fail();
+        if (sameLayout && (keyframe || count != m_frame.size())) return Fail();
+
+        // Runs only copy previous primitives; every other primitive takes at least a byte
+        if (count > (keyframe ? 0 : m_frame.size()) + size) return Fail();
+
+        if (sameLayout) {
+            if (!DecodeTokens(data, end, m_frame, true, false)) return Fail();
+        }
+        else {
+            if (!keyframe) IndexPrevious();
+
+            m_next.resize((size_t)count);
+            if (!DecodeTokens(data, end, m_next, false, keyframe)) return Fail();
+            m_frame.swap(m_next);
+        }
+
+        if (data != end) return Fail();
+
+        m_valid = true;
+        return true;
+    }
+
+    const std::vector<OverlayPrimitive>& GetFrame() const { return m_frame; }
+
+    bool IsValid() const { return m_valid; }
+
+    void Reset() {
+        m_frame.clear();
+        m_valid = false;
+    }
+
+private:
+    std::vector<OverlayPrimitive> m_frame;
+    std::vector<OverlayPrimitive> m_next;
+    std::unordered_map<uint32_t, size_t> m_previousIndex;
+    std::u16string m_units;
+    bool m_valid;
+
+    bool Fail() {
+        m_valid = false;
+        return false;
+    }
+
+    void IndexPrevious() {
+        m_previousIndex.clear();
+        for (size_t i = 0; i < m_frame.size(); ++i) m_previousIndex.emplace(m_frame[i].id, i);
+    }
+
+    // In place when inPlace is set (output is m_frame itself); otherwise references come
+    // from m_frame and output goes to a separate buffer
+    bool DecodeTokens(const uint8_t*& data, const uint8_t* end, std::vector<OverlayPrimitive>& output, bool inPlace, bool keyframe) {
+        size_t walk = 0;
+        uint32_t lastId = (uint32_t)-1;
+        size_t i = 0;
+
+        while (i < output.size()) {
+            uint64_t token;
+            if (!FrameDelta::GetVarint(data, end, &token)) return false;
+
+            if (token & 1) {
+                uint64_t run = token >> 1;
+                if (keyframe || run == 0 || run > output.size() - i) return false;
+
+                for (; run; --run, ++i) {
+                    if (!inPlace) {
+                        if (walk >= m_frame.size()) return false;
+                        output[i] = m_frame[walk++];
+                    }
+                    lastId = output[i].id;
+                }
+                continue;
+            }
+
+            if (token >> 1 > 0xFFFFFFFFu) return false;
+            uint32_t mask = (uint32_t)(token >> 1);
+            if (mask >> 10) return false;
+
+            OverlayPrimitive& primitive = output[i];
+            if (mask & kDeltaExplicitId) {
+                if (inPlace) return false;
+
+                uint64_t code;
+                if (!FrameDelta::GetVarint(data, end, &code)) return false;
+                uint32_t id = (uint32_t)((int64_t)lastId + 1 + FrameDelta::UnZigZag(code));
+
+                auto found = keyframe ? m_previousIndex.end() : m_previousIndex.find(id);
+                if (found != m_previousIndex.end()) {
+                    primitive = m_frame[found->second];
+                    walk = found->second + 1;
+                }
+                else {
+                    primitive = FrameDelta::ZeroPrimitive();
+                }
+                primitive.id = id;
+            }
+            else if (!inPlace) {
+                if (keyframe || walk >= m_frame.size()) return false;
+                primitive = m_frame[walk++];
+            }
+
+            uint64_t value;
+            if (mask & kDeltaTypeFlags) {
+                if (!FrameDelta::GetVarint(data, end, &value)) return false;
+                primitive.type = (uint16_t)value;
+                primitive.flags = (uint16_t)(value >> 16);
+            }
+            if (mask & kDeltaColor) {
+                if (!FrameDelta::GetVarint(data, end, &value)) return false;
+                primitive.color = (uint32_t)value;
+            }
+            for (uint32_t field = 0; field < kDeltaCoordinateCount; ++field) {
+                if (!(mask & (kDeltaX0 << field))) continue;
+
+                if (!FrameDelta::GetVarint(data, end, &value)) return false;
+                int64_t delta = FrameDelta::UnZigZag(value);
+                if (delta > 2 * (int64_t)kDeltaQuantizedLimit || delta < -2 * (int64_t)kDeltaQuantizedLimit) return false;
+
+                float* coordinate = FrameDelta::Coordinate(primitive, field);
+                int64_t quantized = FrameDelta::Quantize(*coordinate) + delta;
+                if (quantized > kDeltaQuantizedLimit || quantized < -kDeltaQuantizedLimit) return false;
+                *coordinate = FrameDelta::Dequantize(quantized);
+            }
+            if (mask & kDeltaText) {
+                uint64_t length;
+                if (!FrameDelta::GetVarint(data, end, &length) || length > (uint64_t)(end - data)) return false;
+
+                m_units.resize((size_t)length);
+                for (size_t unit = 0; unit < length; ++unit) {
+                    if (!FrameDelta::GetVarint(data, end, &value) || value > 0xFFFF) return false;
+                    m_units[unit] = (char16_t)value;
+                }
+                FrameDelta::FromUtf16(m_units, primitive.text);
+            }
+
+            lastId = primitive.id;
+            ++i;
+        }
+
+        return true;
+    }
+};
@@ -0,0 +1,269 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class FrameScheduler;
+
+// Coroutine type for work spread over overlay frames. Tasks start suspended and are
+// owned by the FrameScheduler they are spawned on; a finished task destroys itself.
+//
+//   FrameTask BuildLabels(FrameScheduler& scheduler, Labels& out) {
+//       co_await scheduler.OnWorker();          // continue on a worker thread
+//       SortEntities(...);
+//       co_await scheduler.NextFrame();         // back on the frame thread
+//       for (...) {
+//           AppendLabel(...);
+//           co_await scheduler.BudgetRemaining(); // yields only when the slice is used up
+//       }
+//   }
+class FrameTask {
+public:
+    struct promise_type {
+        FrameScheduler* scheduler = nullptr; // Set by Spawn()
+
+        // The task frees itself once suspended at the end. Whoever resumed it may be on
+        // another thread by then and must not look at the handle after resume() returns.
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume() const noexcept {}
+        };
+
+        FrameTask get_return_object() {
+            return FrameTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    FrameTask() : m_handle(nullptr) {}
+    explicit FrameTask(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    FrameTask(FrameTask&& other) noexcept : m_handle(other.m_handle) {
+        other.m_handle = nullptr;
+    }
+
+    FrameTask& operator=(FrameTask&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) m_handle.destroy();
+            m_handle = other.m_handle;
+            other.m_handle = nullptr;
+        }
+        return *this;
+    }
+
+    FrameTask(const FrameTask&) = delete;
+    FrameTask& operator=(const FrameTask&) = delete;
+
+    ~FrameTask() {
+        if (m_handle) m_handle.destroy();
+    }
+
+private:
+    friend class FrameScheduler;
+
+    std::coroutine_handle<promise_type> Release() {
+        std::coroutine_handle<promise_type> handle = m_handle;
+        m_handle = nullptr;
+        return handle;
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+// Runs FrameTasks inside the overlay frame loop.
+//
+// RunFrame() is called once per frame from the render thread and resumes the tasks queued
+// for that frame until its time slice is used up; the rest carry over, in order, to the
+// next frame. Tasks that moved to a worker thread come back to the render thread with
+// NextFrame(). All queues are thread-safe, so any awaitable may be used on any thread.
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FrameScheduler(unsigned workerThreads = 1)
+        : m_sliceEnd(Clock::now()),
+        m_frameIndex(0),
+        m_liveTasks(0),
+        m_stopping(false) {
+        for (unsigned i = 0; i < workerThreads; ++i) {
+            m_workers.emplace_back(&FrameScheduler::WorkerLoop, this);
+        }
+    }
+
+    ~FrameScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_workAvailable.notify_all();
+
+        for (std::thread& worker : m_workers) {
+            if (worker.joinable()) worker.join();
+        }
+
+        // Tasks that never finished are destroyed where they are suspended
+        for (std::coroutine_handle<> handle : m_frameQueue) handle.destroy();
+        for (std::coroutine_handle<> handle : m_workerQueue) handle.destroy();
+    }
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    // The task first runs in the next RunFrame()
+    void Spawn(FrameTask task) {
+        std::coroutine_handle<FrameTask::promise_type> handle = task.Release();
+        if (!handle) return;
+
+        handle.promise().scheduler = this;
+        m_liveTasks++;
+        QueueForFrame(handle);
+    }
+
+    // Resumes queued tasks for up to sliceUs; at least one task runs per frame so work
+    // always progresses even with a zero slice
+    void RunFrame(int64_t sliceUs) {
+        Clock::time_point start = Clock::now();
+        m_sliceEnd = start + std::chrono::microseconds(sliceUs);
+        m_frameIndex++;
+        FrameScheduler* previous = CurrentFrame();
+        CurrentFrame() = this;
+
+        // Only tasks queued before this frame started; anything requeued now waits a frame
+        std::deque<std::coroutine_handle<>> current;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            current.swap(m_frameQueue);
+        }
+
+        bool ranAny = false;
+        while (!current.empty()) {
+            if (ranAny && Clock::now() >= m_sliceEnd) break;
+
+            std::coroutine_handle<> handle = current.front();
+            current.pop_front();
+            handle.resume();
+            ranAny = true;
+        }
+
+        // Out of time: the remainder goes ahead of what was queued during this frame
+        if (!current.empty()) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_frameQueue.insert(m_frameQueue.begin(), current.begin(), current.end());
+        }
+
+        CurrentFrame() = previous;
+    }
+
+    uint64_t GetFrameIndex() const { return m_frameIndex; }
+
+    // Tasks spawned and not yet finished
+    size_t GetLiveTaskCount() const { return m_liveTasks.load(); }
+
+    // Suspends until the next RunFrame() and resumes on the render thread
+    auto NextFrame() {
+        struct Awaiter {
+            FrameScheduler* scheduler;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->QueueForFrame(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{ this };
+    }
+
+    // Continues immediately while the current frame's slice has time left, otherwise
+    // suspends until the next frame. Returns the microseconds left in the slice.
+    auto BudgetRemaining() {
+        struct Awaiter {
+            FrameScheduler* scheduler;
+            bool await_ready() const noexcept { return scheduler->RemainingUs() > 0; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->QueueForFrame(handle); }
+            int64_t await_resume() const noexcept { return scheduler->RemainingUs(); }
+        };
+        return Awaiter{ this };
+    }
+
+    // Resumes on a worker thread
+    auto OnWorker() {
+        struct Awaiter {
+            FrameScheduler* scheduler;
+            bool await_ready() const noexcept { return scheduler->m_workers.empty(); }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->QueueForWorker(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{ this };
+    }
+
+    // Microseconds left in the current frame's slice; 0 off the render thread or between frames
+    int64_t RemainingUs() const {
+        if (CurrentFrame() != this) return 0;
+
+        int64_t remaining = std::chrono::duration_cast<std::chrono::microseconds>(m_sliceEnd - Clock::now()).count();
+        return remaining > 0 ? remaining : 0;
+    }
+
+private:
+    friend struct FrameTask::promise_type::FinalAwaiter;
+
+    Clock::time_point m_sliceEnd;
+    uint64_t m_frameIndex;
+    std::atomic<size_t> m_liveTasks;
+
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::deque<std::coroutine_handle<>> m_frameQueue;
+    std::deque<std::coroutine_handle<>> m_workerQueue;
+    std::vector<std::thread> m_workers;
+    bool m_stopping;
+
+    // The scheduler whose RunFrame() is executing on this thread
+    static FrameScheduler*& CurrentFrame() {
+        static thread_local FrameScheduler* current = nullptr;
+        return current;
+    }
+
+    void QueueForFrame(std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frameQueue.push_back(handle);
+    }
+
+    void QueueForWorker(std::coroutine_handle<> handle) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_workerQueue.push_back(handle);
+        }
+        m_workAvailable.notify_one();
+    }
+
+    void WorkerLoop() {
+        for (;;) {
+            std::coroutine_handle<> handle;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_workAvailable.wait(lock, [this] { return m_stopping || !m_workerQueue.empty(); });
+                if (m_stopping) return;
+
+                handle = m_workerQueue.front();
+                m_workerQueue.pop_front();
+            }
+
+            handle.resume();
+        }
+    }
+};
+
+inline void FrameTask::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    FrameScheduler* scheduler = handle.promise().scheduler;
+    handle.destroy();
+    if (scheduler) scheduler->m_liveTasks--;
+}
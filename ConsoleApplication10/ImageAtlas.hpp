@@ -0,0 +1,431 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "StampCache.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGEATLAS_SSE2 1
+#endif
+
+// Image atlas
+//
+// Icons and other small images are packed into one shared texture together with their
+// mip chains, so each image is drawn with a single blit from a single bitmap at any
+// scale: the level is the smallest one that still covers the destination on both axes,
+// so bilinear filtering only ever reduces it, by about 2x at most on the tighter axis. Every
+// level has a 1 px border that repeats its edge pixels, so filtering never picks up a
+// neighbour. Pixels are premultiplied BGRA like the stamp atlas.
+
+using ImageId = uint32_t;
+constexpr ImageId kInvalidImage = 0xFFFFFFFFu;
+
+class ImageAtlas {
+public:
+    static constexpr int kMaxImageSize = 512;
+
+    ImageAtlas(int atlasWidth = 1024, int atlasHeight = 1024)
+        : m_width(atlasWidth),
+        m_height(atlasHeight),
+        m_generation(0),
+        m_dirty(false) {
+        m_dirtyRect = { 0, 0, 0, 0 };
+    }
+
+    // pixels are 0xAARRGGBB (B, G, R, A in memory), straight alpha unless premultiplied
+    // is set; stride is in bytes. Returns kInvalidImage when the image is too large or the
+    // atlas is full. Space taken by a failed add is only given back by Clear().
+    ImageId AddImage(const uint32_t* pixels, int width, int height, size_t stride, bool premultiplied = false) {
+        if (!pixels || width <= 0 || height <= 0 || width > kMaxImageSize || height > kMaxImageSize) return kInvalidImage;
+
+        if (m_pixels.empty()) {
+            m_pixels.assign((size_t)m_width * m_height, 0);
+            m_allocator.Reset(m_width, m_height);
+        }
+
+        Image image;
+        image.width = width;
+        image.height = height;
+        image.firstLevel = m_levels.size();
+        image.levelCount = 0;
+
+        // Reserve the whole chain first so a full atlas leaves no half-built image behind
+        size_t levelsBefore = m_levels.size();
+        for (int levelWidth = width, levelHeight = height;; levelWidth = (std::max)(levelWidth / 2, 1), levelHeight = (std::max)(levelHeight / 2, 1)) {
+            StampRect rect;
+            if (!m_allocator.Allocate(levelWidth + 2, levelHeight + 2, &rect)) {
+                m_levels.resize(levelsBefore);
+                return kInvalidImage;
+            }
+
+            m_levels.push_back({ rect.x + 1, rect.y + 1, levelWidth, levelHeight });
+            image.levelCount++;
+            if (levelWidth == 1 && levelHeight == 1) break;
+        }
+
+        // Level 0 from the caller's pixels, each further level from the one above it
+        const StampRect& base = m_levels[image.firstLevel];
+        for (int y = 0; y < height; ++y) {
+            const uint32_t* source = reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(pixels) + (size_t)y * stride);
+            uint32_t* target = At(base.x, base.y + y);
+            for (int x = 0; x < width; ++x) target[x] = premultiplied ? source[x] : Premultiply(source[x]);
+        }
+
+        for (int level = 1; level < image.levelCount; ++level) {
+            const StampRect& above = m_levels[image.firstLevel + level - 1];
+            const StampRect& current = m_levels[image.firstLevel + level];
+            BoxDownsample(At(above.x, above.y), above.width, above.height, At(current.x, current.y), current.width, current.height, (size_t)m_width);
+        }
+
+        for (int level = 0; level < image.levelCount; ++level) {
+            const StampRect& rect = m_levels[image.firstLevel + level];
+            FillBorder(rect);
+            MarkDirty({ rect.x - 1, rect.y - 1, rect.width + 2, rect.height + 2 });
+        }
+
+        m_images.push_back(image);
+        return (ImageId)(m_images.size() - 1);
+    }
+
+    bool GetImageSize(ImageId id, int* width, int* height) const {
+        if (id >= m_images.size()) return false;
+
+        *width = m_images[id].width;
+        *height = m_images[id].height;
+        return true;
+    }
+
+    int GetLevelCount(ImageId id) const {
+        return id < m_images.size() ? m_images[id].levelCount : 0;
+    }
+
+    // Smallest level that is still at least as large as the destination on both axes, or
+    // level 0 when even that is smaller. Compares the real level sizes, which odd sizes
+    // round down at every step.
+    int SelectLevel(ImageId id, float destWidth, float destHeight) const {
+        if (id >= m_images.size() || !(destWidth > 0.0f) || !(destHeight > 0.0f)) return 0;
+
+        const Image& image = m_images[id];
+        int level = 0;
+        while (level + 1 < image.levelCount) {
+            const StampRect& next = m_levels[image.firstLevel + level + 1];
+            if (next.width < destWidth || next.height < destHeight) break;
+            level++;
+        }
+        return level;
+    }
+
+    // Location of a level in the atlas, without its border
+    bool GetLevel(ImageId id, int level, StampRect* rect) const {
+        if (id >= m_images.size() || level < 0 || level >= m_images[id].levelCount) return false;
+
+        *rect = m_levels[m_images[id].firstLevel + level];
+        return true;
+    }
+
+    const uint32_t* GetPixels() const { return m_pixels.empty() ? nullptr : m_pixels.data(); }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    size_t GetStride() const { return (size_t)m_width * sizeof(uint32_t); }
+    size_t GetImageCount() const { return m_images.size(); }
+
+    // Incremented every time the atlas is cleared
+    uint32_t GetGeneration() const { return m_generation; }
+
+    // Region written since the last ClearDirty(), for partial texture uploads
+    bool GetDirtyRect(StampRect* rect) const {
+        if (!m_dirty) return false;
+        *rect = m_dirtyRect;
+        return true;
+    }
+
+    void ClearDirty() { m_dirty = false; }
+
+    // Drops every image; ids handed out before become invalid
+    void Clear() {
+        m_images.clear();
+        m_levels.clear();
+        std::fill(m_pixels.begin(), m_pixels.end(), 0u);
+        m_allocator.Reset(m_width, m_height);
+        m_generation++;
+        m_dirty = false;
+    }
+
+    static uint32_t Premultiply(uint32_t pixel) {
+        uint32_t alpha = pixel >> 24;
+        if (alpha == 255) return pixel;
+
+        uint32_t rb = (pixel & 0x00FF00FF) * alpha + 0x00800080;
+        uint32_t g = (pixel & 0x0000FF00) * alpha + 0x00008000;
+        rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        g = ((g + ((g >> 8) & 0x0000FF00)) >> 8) & 0x0000FF00;
+        return (alpha << 24) | rb | g;
+    }
+
+    // 2x2 box filter of premultiplied pixels. With an odd size the last output pixel takes the
+    // last three source pixels on that axis, weighted 1-2-1, so edge rows and columns still
+    // reach the lower levels. A 1-pixel side is averaged along the other axis only. Strides
+    // are in pixels.
+    static void BoxDownsample(const uint32_t* source, int sourceWidth, int sourceHeight,
+        uint32_t* target, int targetWidth, int targetHeight, size_t stride) {
+        bool oddColumn = targetWidth * 2 < sourceWidth;
+        bool oddRow = targetHeight * 2 < sourceHeight;
+        int evenWidth = oddColumn ? targetWidth - 1 : targetWidth;
+        int evenHeight = oddRow ? targetHeight - 1 : targetHeight;
+
+        for (int y = 0; y < evenHeight; ++y) {
+            const uint32_t* row0 = source + (size_t)(std::min)(y * 2, sourceHeight - 1) * stride;
+            const uint32_t* row1 = source + (size_t)(std::min)(y * 2 + 1, sourceHeight - 1) * stride;
+            uint32_t* out = target + (size_t)y * stride;
+            int x = 0;
+
+#ifdef IMAGEATLAS_SSE2
+            // Four output pixels from eight source columns per step, 16 bits per channel
+            if (sourceWidth >= 2) {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i two = _mm_set1_epi16(2);
+                for (; x + 4 <= evenWidth && x * 2 + 8 <= sourceWidth; x += 4) {
+                    __m128i top0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 2));
+                    __m128i top1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 2 + 4));
+                    __m128i bottom0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 2));
+                    __m128i bottom1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 2 + 4));
+
+                    // Column sums: pixels 0-1, 2-3, 4-5, 6-7
+                    __m128i sum01 = _mm_add_epi16(_mm_unpacklo_epi8(top0, zero), _mm_unpacklo_epi8(bottom0, zero));
+                    __m128i sum23 = _mm_add_epi16(_mm_unpackhi_epi8(top0, zero), _mm_unpackhi_epi8(bottom0, zero));
+                    __m128i sum45 = _mm_add_epi16(_mm_unpacklo_epi8(top1, zero), _mm_unpacklo_epi8(bottom1, zero));
+                    __m128i sum67 = _mm_add_epi16(_mm_unpackhi_epi8(top1, zero), _mm_unpackhi_epi8(bottom1, zero));
+
+                    // Even columns plus odd columns
+                    __m128i first = _mm_add_epi16(_mm_unpacklo_epi64(sum01, sum23), _mm_unpackhi_epi64(sum01, sum23));
+                    __m128i second = _mm_add_epi16(_mm_unpacklo_epi64(sum45, sum67), _mm_unpackhi_epi64(sum45, sum67));
+                    first = _mm_srli_epi16(_mm_add_epi16(first, two), 2);
+                    second = _mm_srli_epi16(_mm_add_epi16(second, two), 2);
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(first, second));
+                }
+            }
+#endif
+
+            // Clamped before doubling, which also keeps GCC from warning that x * 2 may overflow
+            for (; x < evenWidth; ++x) {
+                int x0 = (std::min)(x, (sourceWidth - 1) / 2) * 2;
+                int x1 = (std::min)(x0 + 1, sourceWidth - 1);
+                out[x] = Average4(row0[x0], row0[x1], row1[x0], row1[x1]);
+            }
+        }
+
+        // The odd last column and row, shared by both paths above
+        if (oddColumn || oddRow) DownsampleOddEdges(source, sourceWidth, sourceHeight, target, targetWidth, targetHeight, stride);
+    }
+
+private:
+    struct Image {
+        int width;
+        int height;
+        size_t firstLevel; // Index into m_levels
+        int levelCount;
+    };
+
+    int m_width;
+    int m_height;
+    uint32_t m_generation;
+    bool m_dirty;
+    StampRect m_dirtyRect;
+    std::vector<uint32_t> m_pixels;
+    AtlasAllocator m_allocator;
+    std::vector<Image> m_images;
+    std::vector<StampRect> m_levels;
+
+    uint32_t* At(int x, int y) {
+        return m_pixels.data() + (size_t)y * m_width + x;
+    }
+
+    static uint32_t Average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        uint32_t rb = (a & 0x00FF00FF) + (b & 0x00FF00FF) + (c & 0x00FF00FF) + (d & 0x00FF00FF) + 0x00020002;
+        uint32_t ag = ((a >> 8) & 0x00FF00FF) + ((b >> 8) & 0x00FF00FF) + ((c >> 8) & 0x00FF00FF) + ((d >> 8) & 0x00FF00FF) + 0x00020002;
+        return ((rb >> 2) & 0x00FF00FF) | (((ag >> 2) & 0x00FF00FF) << 8);
+    }
+
+    // Filters the last output column and row of BoxDownsample where the source size is odd
+    static void DownsampleOddEdges(const uint32_t* source, int sourceWidth, int sourceHeight,
+        uint32_t* target, int targetWidth, int targetHeight, size_t stride) {
+        if (targetWidth * 2 < sourceWidth) {
+            DownsampleTaps columns = GetTaps(targetWidth - 1, sourceWidth, targetWidth);
+            for (int y = 0; y < targetHeight; ++y) {
+                target[(size_t)y * stride + targetWidth - 1] = WeightedAverage(source, stride, GetTaps(y, sourceHeight, targetHeight), columns);
+            }
+        }
+        if (targetHeight * 2 < sourceHeight) {
+            DownsampleTaps rows = GetTaps(targetHeight - 1, sourceHeight, targetHeight);
+            for (int x = 0; x < targetWidth; ++x) {
+                target[(size_t)(targetHeight - 1) * stride + x] = WeightedAverage(source, stride, rows, GetTaps(x, sourceWidth, targetWidth));
+            }
+        }
+    }
+
+    // Source pixels behind one output pixel on one axis of BoxDownsample, weights adding up to 4
+    struct DownsampleTaps {
+        int index[3];
+        int weight[3];
+    };
+
+    static DownsampleTaps GetTaps(int i, int sourceSize, int targetSize) {
+        bool odd = i == targetSize - 1 && i * 2 + 2 < sourceSize;
+        DownsampleTaps taps;
+        taps.index[0] = (std::min)(i * 2, sourceSize - 1);
+        taps.index[1] = (std::min)(i * 2 + 1, sourceSize - 1);
+        taps.index[2] = (std::min)(i * 2 + 2, sourceSize - 1);
+        taps.weight[0] = odd ? 1 : 2;
+        taps.weight[1] = 2;
+        taps.weight[2] = odd ? 1 : 0;
+        return taps;
+    }
+
+    // Rounded average of the rows x columns taps, 16 weights in all
+    static uint32_t WeightedAverage(const uint32_t* source, size_t stride, const DownsampleTaps& rows, const DownsampleTaps& columns) {
+        uint32_t rb = 0x00080008;
+        uint32_t ag = 0x00080008;
+        for (int i = 0; i < 3; ++i) {
+            const uint32_t* row = source + (size_t)rows.index[i] * stride;
+            for (int j = 0; j < 3; ++j) {
+                uint32_t weight = (uint32_t)(rows.weight[i] * columns.weight[j]);
+                uint32_t pixel = row[columns.index[j]];
+                rb += (pixel & 0x00FF00FF) * weight;
+                ag += ((pixel >> 8) & 0x00FF00FF) * weight;
+            }
+        }
+        return ((rb >> 4) & 0x00FF00FF) | (((ag >> 4) & 0x00FF00FF) << 8);
+    }
+
+    // Repeats the outermost pixels of a level into its border, corners included
+    void FillBorder(const StampRect& rect) {
+        for (int y = 0; y < rect.height; ++y) {
+            uint32_t* row = At(rect.x, rect.y + y);
+            row[-1] = row[0];
+            row[rect.width] = row[rect.width - 1];
+        }
+
+        size_t rowBytes = (size_t)(rect.width + 2) * sizeof(uint32_t);
+        std::memcpy(At(rect.x - 1, rect.y - 1), At(rect.x - 1, rect.y), rowBytes);
+        std::memcpy(At(rect.x - 1, rect.y + rect.height), At(rect.x - 1, rect.y + rect.height - 1), rowBytes);
+    }
+
+    void MarkDirty(const StampRect& rect) {
+        if (!m_dirty) {
+            m_dirtyRect = rect;
+            m_dirty = true;
+            return;
+        }
+
+        int right = (std::max)(m_dirtyRect.x + m_dirtyRect.width, rect.x + rect.width);
+        int bottom = (std::max)(m_dirtyRect.y + m_dirtyRect.height, rect.y + rect.height);
+        m_dirtyRect.x = (std::min)(m_dirtyRect.x, rect.x);
+        m_dirtyRect.y = (std::min)(m_dirtyRect.y, rect.y);
+        m_dirtyRect.width = right - m_dirtyRect.x;
+        m_dirtyRect.height = bottom - m_dirtyRect.y;
+    }
+};
+
+// Portable BlendBilinear; the SSE2 version gives the same results bit for bit
+inline uint32_t BlendBilinearScalar(uint32_t dest, uint32_t p00, uint32_t p10, uint32_t p01, uint32_t p11,
+    uint32_t fx, uint32_t fy, uint32_t opacity) {
+    uint32_t s = LerpPixel(LerpPixel(p00, p01, fy), LerpPixel(p10, p11, fy), fx);
+    if (opacity < 256) s = LerpPixel(0, s, opacity);
+
+    uint32_t inverseAlpha = 255 - (s >> 24);
+    uint32_t drb = ((dest & 0x00FF00FF) * inverseAlpha + 0x00800080) >> 8;
+    uint32_t dag = (((dest >> 8) & 0x00FF00FF) * inverseAlpha + 0x00800080) >> 8;
+    return s + ((drb & 0x00FF00FF) | ((dag & 0x00FF00FF) << 8));
+}
+
+// Bilinear sample of four premultiplied pixels followed by premultiplied source-over onto
+// dest. fx and fy weight the right and bottom pixels, 0..256; opacity is 0..256.
+inline uint32_t BlendBilinear(uint32_t dest, uint32_t p00, uint32_t p10, uint32_t p01, uint32_t p11,
+    uint32_t fx, uint32_t fy, uint32_t opacity) {
+#ifdef IMAGEATLAS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i top = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p00), zero);
+    top = _mm_unpacklo_epi64(top, _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p10), zero));
+    __m128i bottom = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p01), zero);
+    bottom = _mm_unpacklo_epi64(bottom, _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p11), zero));
+
+    // Vertical lerp of the left and right columns at once, then the horizontal lerp
+    __m128i columns = _mm_srli_epi16(_mm_add_epi16(
+        _mm_mullo_epi16(top, _mm_set1_epi16((short)(256 - fy))),
+        _mm_mullo_epi16(bottom, _mm_set1_epi16((short)fy))), 8);
+    __m128i weighted = _mm_mullo_epi16(columns, _mm_set_epi16(
+        (short)fx, (short)fx, (short)fx, (short)fx,
+        (short)(256 - fx), (short)(256 - fx), (short)(256 - fx), (short)(256 - fx)));
+    __m128i source = _mm_srli_epi16(_mm_add_epi16(weighted, _mm_srli_si128(weighted, 8)), 8);
+    if (opacity < 256) source = _mm_srli_epi16(_mm_mullo_epi16(source, _mm_set1_epi16((short)opacity)), 8);
+
+    __m128i inverseAlpha = _mm_sub_epi16(_mm_set1_epi16(255), _mm_shufflelo_epi16(source, _MM_SHUFFLE(3, 3, 3, 3)));
+    __m128i target = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)dest), zero);
+    target = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(target, inverseAlpha), _mm_set1_epi16(0x80)), 8);
+    return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(_mm_add_epi16(source, target), zero));
+#else
+    return BlendBilinearScalar(dest, p00, p10, p01, p11, fx, fy, opacity);
+#endif
+}
+
+// Draws an image into a premultiplied BGRA surface, scaled to [left, right) x [top, bottom).
+// The mip level is chosen as for the GPU path and sampled bilinearly; pixels whose centres
+// fall inside the rectangle are written. stride is in bytes.
+inline void BlitImage(uint32_t* target, int targetWidth, int targetHeight, size_t stride,
+    const ImageAtlas& atlas, ImageId id, float left, float top, float right, float bottom, float opacity = 1.0f) {
+    const uint32_t* pixels = atlas.GetPixels();
+    if (!pixels || !target || right <= left || bottom <= top) return;
+
+    StampRect level;
+    if (!atlas.GetLevel(id, atlas.SelectLevel(id, right - left, bottom - top), &level)) return;
+
+    uint32_t alpha = (uint32_t)((opacity < 0.0f ? 0.0f : (opacity > 1.0f ? 1.0f : opacity)) * 256.0f + 0.5f);
+    if (!alpha) return;
+
+    int x0 = (std::max)((int)std::ceil(left - 0.5f), 0);
+    int y0 = (std::max)((int)std::ceil(top - 0.5f), 0);
+    int x1 = (std::min)((int)std::ceil(right - 0.5f), targetWidth);
+    int y1 = (std::min)((int)std::ceil(bottom - 0.5f), targetHeight);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    // Source position of a destination pixel centre in 16.16 fixed point, shifted by half a
+    // texel so the integer part is the left/top tap. Taps range over [-1, size], which the
+    // level border covers.
+    double scaleX = level.width / (double)(right - left);
+    double scaleY = level.height / (double)(bottom - top);
+    int64_t startX = (int64_t)std::floor(((x0 + 0.5 - left) * scaleX - 0.5) * 65536.0);
+    int64_t stepX = (int64_t)std::floor(scaleX * 65536.0);
+    size_t atlasStride = (size_t)atlas.GetWidth();
+    const uint32_t* origin = pixels + (size_t)level.y * atlasStride + level.x;
+
+    for (int y = y0; y < y1; ++y) {
+        int64_t v = (int64_t)std::floor(((y + 0.5 - top) * scaleY - 0.5) * 65536.0);
+        int sy = (int)(v >> 16);
+        uint32_t fy = (uint32_t)((v >> 8) & 0xFF);
+        if (sy < -1) { sy = -1; fy = 0; }
+        if (sy > level.height - 1) { sy = level.height - 1; fy = 0; }
+
+        const uint32_t* row0 = origin + (ptrdiff_t)sy * (ptrdiff_t)atlasStride;
+        const uint32_t* row1 = row0 + atlasStride;
+        uint32_t* out = reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(target) + (size_t)y * stride);
+
+        int64_t u = startX;
+        for (int x = x0; x < x1; ++x, u += stepX) {
+            int sx = (int)(u >> 16);
+            uint32_t fx = (uint32_t)((u >> 8) & 0xFF);
+            if (sx < -1) { sx = -1; fx = 0; }
+            if (sx > level.width - 1) { sx = level.width - 1; fx = 0; }
+
+            uint32_t p00 = row0[sx], p10 = row0[sx + 1], p01 = row1[sx], p11 = row1[sx + 1];
+            if (!(p00 | p10 | p01 | p11)) continue;
+
+            out[x] = BlendBilinear(out[x], p00, p10, p01, p11, fx, fy, alpha);
+        }
+    }
+}
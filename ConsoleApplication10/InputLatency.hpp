@@ -0,0 +1,241 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Timestamps used from input sampling to present, in microseconds. On Windows this is
+// QueryPerformanceCounter so that DWM timing info (also QPC) can be compared directly.
+class LatencyClock {
+public:
+    static int64_t NowUs() {
+#ifdef _WIN32
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return QpcToUs(counter.QuadPart);
+#else
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+#ifdef _WIN32
+    static int64_t QpcToUs(int64_t qpc) {
+        static const int64_t frequency = [] {
+            LARGE_INTEGER value;
+            QueryPerformanceFrequency(&value);
+            return value.QuadPart;
+        }();
+        return (qpc / frequency) * 1000000 + (qpc % frequency) * 1000000 / frequency;
+    }
+#endif
+};
+
+// Latency distribution over the most recent samples
+class LatencyStats {
+public:
+    explicit LatencyStats(size_t capacity = 1024)
+        : m_capacity(capacity ? capacity : 1),
+        m_next(0),
+        m_total(0) {
+        m_samples.reserve(m_capacity);
+    }
+
+    void Add(int64_t latencyUs) {
+        if (latencyUs < 0) return;
+
+        if (m_samples.size() < m_capacity) {
+            m_samples.push_back(latencyUs);
+        }
+        else {
+            m_samples[m_next] = latencyUs;
+            m_next = (m_next + 1) % m_capacity;
+        }
+        m_total++;
+    }
+
+    void Reset() {
+        m_samples.clear();
+        m_next = 0;
+        m_total = 0;
+    }
+
+    size_t GetCount() const { return m_samples.size(); }
+    uint64_t GetTotalCount() const { return m_total; }
+
+    // p in [0, 1]; nearest-rank over the retained window, 0 when empty
+    int64_t Percentile(double p) const {
+        if (m_samples.empty()) return 0;
+
+        std::vector<int64_t> sorted(m_samples);
+        size_t rank = (size_t)std::ceil((std::min)((std::max)(p, 0.0), 1.0) * sorted.size());
+        size_t index = rank ? rank - 1 : 0;
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        return sorted[index];
+    }
+
+    double Mean() const {
+        if (m_samples.empty()) return 0.0;
+
+        double sum = 0.0;
+        for (int64_t sample : m_samples) sum += (double)sample;
+        return sum / m_samples.size();
+    }
+
+    int64_t Max() const {
+        return m_samples.empty() ? 0 : *std::max_element(m_samples.begin(), m_samples.end());
+    }
+
+    void WriteReport(std::ostream& out, const char* name) const {
+        char line[256];
+        snprintf(line, sizeof(line), "%-20s n=%-5zu mean %7.2f ms  p50 %7.2f ms  p90 %7.2f ms  p99 %7.2f ms  max %7.2f ms\n",
+            name, GetCount(), Mean() / 1000.0,
+            Percentile(0.50) / 1000.0, Percentile(0.90) / 1000.0, Percentile(0.99) / 1000.0, Max() / 1000.0);
+        out << line;
+    }
+
+private:
+    size_t m_capacity;
+    size_t m_next;
+    uint64_t m_total;
+    std::vector<int64_t> m_samples;
+};
+
+// Extrapolates a moving point to a future time.
+//
+// Velocity (and optionally acceleration) come from a least-squares fit over the samples
+// of the last fitWindowUs, which is robust to the staircase pattern seen when the frame
+// loop samples faster than the input device reports. The prediction starts from the
+// latest observed position and the horizon is clamped, so a bad fit can never throw the
+// point far off. A gap longer than the fit window restarts the history.
+class MotionPredictor {
+public:
+    struct Point {
+        float x, y;
+    };
+
+    MotionPredictor(int64_t fitWindowUs = 50000, int64_t maxHorizonUs = 50000, bool useAcceleration = true)
+        : m_fitWindowUs(fitWindowUs),
+        m_maxHorizonUs(maxHorizonUs),
+        m_useAcceleration(useAcceleration),
+        m_count(0),
+        m_head(0) {
+    }
+
+    void AddSample(int64_t timeUs, float x, float y) {
+        if (m_count) {
+            const Sample& last = Latest();
+            if (timeUs < last.timeUs || timeUs - last.timeUs > m_fitWindowUs) Reset();
+            else if (timeUs == last.timeUs) {
+                // Same timestamp: the new sample replaces the latest one
+                m_head = (m_head + kCapacity - 1) % kCapacity;
+                m_count--;
+            }
+        }
+
+        m_samples[m_head] = { timeUs, x, y };
+        m_head = (m_head + 1) % kCapacity;
+        if (m_count < kCapacity) m_count++;
+    }
+
+    void Reset() {
+        m_count = 0;
+        m_head = 0;
+    }
+
+    bool HasSamples() const { return m_count > 0; }
+
+    int64_t GetLatestTime() const { return m_count ? Latest().timeUs : 0; }
+
+    Point Predict(int64_t targetTimeUs) const {
+        if (!m_count) return { 0.0f, 0.0f };
+
+        const Sample& latest = Latest();
+        Point result = { latest.x, latest.y };
+
+        int64_t horizonUs = (std::min)(targetTimeUs - latest.timeUs, m_maxHorizonUs);
+        if (horizonUs <= 0 || m_count < 2) return result;
+
+        double vx, vy, ax, ay;
+        if (!Fit(latest.timeUs, &vx, &vy, &ax, &ay)) return result;
+
+        double dt = horizonUs / 1000.0;
+        result.x = (float)(latest.x + vx * dt + 0.5 * ax * dt * dt);
+        result.y = (float)(latest.y + vy * dt + 0.5 * ay * dt * dt);
+        return result;
+    }
+
+private:
+    static const size_t kCapacity = 32;
+
+    struct Sample {
+        int64_t timeUs;
+        float x, y;
+    };
+
+    int64_t m_fitWindowUs;
+    int64_t m_maxHorizonUs;
+    bool m_useAcceleration;
+    Sample m_samples[kCapacity];
+    size_t m_count;
+    size_t m_head;
+
+    const Sample& Latest() const {
+        return m_samples[(m_head + kCapacity - 1) % kCapacity];
+    }
+
+    // Fits x(t) = c + v t + a t^2 / 2 (or c + v t) around t = 0 at the latest sample.
+    // Time is in milliseconds to keep the power sums well scaled.
+    bool Fit(int64_t latestUs, double* vx, double* vy, double* ax, double* ay) const {
+        // Power sums of t and moments of x and y
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0, s4 = 0;
+        double x0 = 0, x1 = 0, x2 = 0, y0 = 0, y1 = 0, y2 = 0;
+        size_t used = 0;
+
+        for (size_t i = 0; i < m_count; ++i) {
+            const Sample& sample = m_samples[(m_head + kCapacity - 1 - i) % kCapacity];
+            if (latestUs - sample.timeUs > m_fitWindowUs) break;
+
+            double t = (sample.timeUs - latestUs) / 1000.0;
+            double t2 = t * t;
+            s0 += 1; s1 += t; s2 += t2; s3 += t2 * t; s4 += t2 * t2;
+            x0 += sample.x; x1 += sample.x * t; x2 += sample.x * t2;
+            y0 += sample.y; y1 += sample.y * t; y2 += sample.y * t2;
+            used++;
+        }
+
+        if (used < 2) return false;
+
+        if (m_useAcceleration && used >= 4) {
+            // Normal equations for [c, v, a/2], solved with Cramer's rule
+            double det = s0 * (s2 * s4 - s3 * s3) - s1 * (s1 * s4 - s3 * s2) + s2 * (s1 * s3 - s2 * s2);
+            if (std::fabs(det) > 1e-9) {
+                auto solve = [&](double m0, double m1, double m2, double* v, double* a) {
+                    double detV = s0 * (m1 * s4 - s3 * m2) - m0 * (s1 * s4 - s3 * s2) + s2 * (s1 * m2 - m1 * s2);
+                    double detA = s0 * (s2 * m2 - m1 * s3) - s1 * (s1 * m2 - m1 * s2) + m0 * (s1 * s3 - s2 * s2);
+                    *v = detV / det;
+                    *a = 2.0 * detA / det;
+                };
+                solve(x0, x1, x2, vx, ax);
+                solve(y0, y1, y2, vy, ay);
+                return true;
+            }
+        }
+
+        double det = s0 * s2 - s1 * s1;
+        if (std::fabs(det) < 1e-9) return false;
+
+        *vx = (s0 * x1 - s1 * x0) / det;
+        *vy = (s0 * y1 - s1 * y0) / det;
+        *ax = 0.0;
+        *ay = 0.0;
+        return true;
+    }
+};
@@ -0,0 +1,470 @@
+#pragma once
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Compiled overlay scene (.ovs)
+//
+// A scene is a single little-endian blob that is used in place, straight out of a
+// memory mapping: a fixed header, an 8-byte aligned array of fixed-size element
+// records and a table of NUL-terminated UTF-16 strings. Every reference inside the
+// blob is an offset from the start of the blob, so it is fully relocatable and can
+// be mapped at any address. Loading only validates the header (O(1)); per-element
+// string references are bounds-checked when they are accessed.
+
+enum class SceneElementType : uint16_t {
+    Line = 1,
+    SolidCircle,
+    HollowCircle,
+    HollowDiamond,
+    CornerBox,
+    SolidRectangle,
+    HollowRectangle,
+    Text,
+};
+
+#pragma pack(push, 1)
+struct SceneHeader {
+    char magic[4];          // "OVSC"
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t fileSize;
+    uint32_t elementCount;
+    uint32_t elementOffset; // Byte offset of the first SceneElement
+    uint32_t stringOffset;  // Byte offset of the string table
+    uint32_t stringBytes;   // Size of the string table in bytes
+    float designWidth;      // Coordinate space the scene was authored in
+    float designHeight;
+    uint32_t reserved;
+};
+
+struct SceneElement {
+    uint16_t type;          // SceneElementType
+    uint16_t flags;
+    uint32_t color;         // 0xRRGGBBAA
+    float x0, y0;           // Start point / center / top-left / text origin
+    float x1, y1;           // End point / bottom-right
+    float size;             // Radius or font size
+    float stroke;           // Stroke width
+    uint32_t textOffset;    // Byte offset into the string table
+    uint32_t textLength;    // Length in UTF-16 code units, excluding the terminator
+};
+#pragma pack(pop)
+
+static_assert(sizeof(SceneHeader) == 40, "SceneHeader layout is part of the file format");
+static_assert(sizeof(SceneElement) == 40, "SceneElement layout is part of the file format");
+
+constexpr uint16_t kSceneVersion = 1;
+constexpr uint16_t kSceneFlagLowPriority = 0x0001; // Skipped when the overlay sheds load
+constexpr uint32_t kSceneAlignment = 8;
+
+// Non-owning, zero-copy view over a compiled scene
+class OverlaySceneView {
+public:
+    OverlaySceneView() : m_base(nullptr), m_size(0) {}
+
+    // Validates the header and section bounds; does not touch the element records
+    bool Attach(const void* data, size_t size) {
+        m_base = nullptr;
+        m_size = 0;
+
+        if (!data || size < sizeof(SceneHeader)) return false;
+        if (reinterpret_cast<uintptr_t>(data) % kSceneAlignment) return false;
+
+        const SceneHeader* header = static_cast<const SceneHeader*>(data);
+        if (memcmp(header->magic, "OVSC", 4) != 0) return false;
+        if (header->version != kSceneVersion || header->headerSize != sizeof(SceneHeader)) return false;
+        if (header->fileSize > size) return false;
+        if (header->elementOffset % kSceneAlignment) return false;
+        if (header->elementOffset < sizeof(SceneHeader)) return false;
+
+        uint64_t elementsEnd = (uint64_t)header->elementOffset + (uint64_t)header->elementCount * sizeof(SceneElement);
+        if (elementsEnd > header->fileSize) return false;
+
+        uint64_t stringsEnd = (uint64_t)header->stringOffset + header->stringBytes;
+        if (header->stringOffset % sizeof(char16_t) || stringsEnd > header->fileSize) return false;
+
+        // Written so that NaN fails too
+        if (!(header->designWidth > 0.0f) || !(header->designHeight > 0.0f)) return false;
+
+        m_base = static_cast<const uint8_t*>(data);
+        m_size = header->fileSize;
+        return true;
+    }
+
+    bool IsValid() const { return m_base != nullptr; }
+
+    const SceneHeader& GetHeader() const {
+        return *reinterpret_cast<const SceneHeader*>(m_base);
+    }
+
+    uint32_t GetElementCount() const {
+        return m_base ? GetHeader().elementCount : 0;
+    }
+
+    const SceneElement* GetElements() const {
+        return m_base ? reinterpret_cast<const SceneElement*>(m_base + GetHeader().elementOffset) : nullptr;
+    }
+
+    // Returns a NUL-terminated string for a Text element, or nullptr if the reference is out of bounds
+    const char16_t* GetText(const SceneElement& element) const {
+        const SceneHeader& header = GetHeader();
+        uint64_t end = (uint64_t)element.textOffset + ((uint64_t)element.textLength + 1) * sizeof(char16_t);
+        if (element.textOffset % sizeof(char16_t) || end > header.stringBytes) return nullptr;
+
+        const char16_t* text = reinterpret_cast<const char16_t*>(m_base + header.stringOffset + element.textOffset);
+        if (text[element.textLength] != 0) return nullptr;
+        return text;
+    }
+
+    const void* GetData() const { return m_base; }
+    size_t GetSize() const { return m_size; }
+
+private:
+    const uint8_t* m_base;
+    size_t m_size;
+};
+
+// Read-only memory mapping of a compiled scene file
+class OverlaySceneFile {
+public:
+    OverlaySceneFile()
+        : m_pData(nullptr),
+        m_size(0)
+#ifdef _WIN32
+        , m_hFile(INVALID_HANDLE_VALUE),
+        m_hMapping(0)
+#endif
+    {
+    }
+
+    ~OverlaySceneFile() {
+        Close();
+    }
+
+    OverlaySceneFile(const OverlaySceneFile&) = delete;
+    OverlaySceneFile& operator=(const OverlaySceneFile&) = delete;
+
+    bool Open(const char* path) {
+        Close();
+
+#ifdef _WIN32
+        m_hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        if (m_hFile == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart == 0) {
+            Close();
+            return false;
+        }
+
+        m_hMapping = CreateFileMappingA(m_hFile, 0, PAGE_READONLY, 0, 0, 0);
+        if (!m_hMapping) {
+            Close();
+            return false;
+        }
+
+        m_pData = MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+        m_size = (size_t)fileSize.QuadPart;
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return false;
+        }
+
+        void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) return false;
+
+        m_pData = mapping;
+        m_size = (size_t)st.st_size;
+#endif
+
+        if (!m_pData || !m_view.Attach(m_pData, m_size)) {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void Close() {
+        m_view = OverlaySceneView();
+
+#ifdef _WIN32
+        if (m_pData) UnmapViewOfFile(m_pData);
+        if (m_hMapping) CloseHandle(m_hMapping);
+        if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+        m_hMapping = 0;
+        m_hFile = INVALID_HANDLE_VALUE;
+#else
+        if (m_pData) munmap(m_pData, m_size);
+#endif
+
+        m_pData = nullptr;
+        m_size = 0;
+    }
+
+    const OverlaySceneView& GetView() const { return m_view; }
+
+private:
+    void* m_pData;
+    size_t m_size;
+    OverlaySceneView m_view;
+#ifdef _WIN32
+    HANDLE m_hFile;
+    HANDLE m_hMapping;
+#endif
+};
+
+// Compiles the text scene description into the binary format.
+//
+// One element per line. A token starting with '#' starts a comment unless it is a color
+// (#RRGGBB or #RRGGBBAA). Positions, radii and font sizes are in canvas units and scaled
+// to the overlay at draw time; stroke widths are in pixels. A trailing "low" marks an
+// element as low priority.
+//   canvas    <width> <height>
+//   line      <x0> <y0> <x1> <y1> <stroke> <color>
+//   circle    <cx> <cy> <radius> <color>
+//   ring      <cx> <cy> <radius> <stroke> <color>
+//   diamond   <cx> <cy> <radius> <stroke> <color>
+//   cornerbox <left> <top> <right> <bottom> <stroke> <color>
+//   rect      <left> <top> <right> <bottom> <color>
+//   frame     <left> <top> <right> <bottom> <stroke> <color>
+//   text      <x> <y> <fontSize> <color> "<utf-8 text>"
+class OverlaySceneCompiler {
+public:
+    static bool Compile(std::istream& input, std::vector<uint8_t>& output, std::string* error = nullptr) {
+        std::vector<SceneElement> elements;
+        std::vector<char16_t> strings;
+        float designWidth = 1000.0f;
+        float designHeight = 1000.0f;
+
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(input, line)) {
+            ++lineNumber;
+
+            size_t comment = FindComment(line);
+            if (comment != std::string::npos) line.erase(comment);
+
+            std::istringstream stream(line);
+            std::string keyword;
+            if (!(stream >> keyword)) continue;
+
+            SceneElement element{};
+            bool ok = true;
+
+            if (keyword == "canvas") {
+                ok = static_cast<bool>(stream >> designWidth >> designHeight) && designWidth > 0 && designHeight > 0;
+                if (!ok) return Fail(error, lineNumber, "invalid canvas size");
+
+                std::string trailing;
+                if (stream >> trailing) return Fail(error, lineNumber, "unexpected '" + trailing + "'");
+                continue;
+            }
+            else if (keyword == "line") {
+                element.type = (uint16_t)SceneElementType::Line;
+                ok = static_cast<bool>(stream >> element.x0 >> element.y0 >> element.x1 >> element.y1 >> element.stroke);
+            }
+            else if (keyword == "circle") {
+                element.type = (uint16_t)SceneElementType::SolidCircle;
+                ok = static_cast<bool>(stream >> element.x0 >> element.y0 >> element.size);
+            }
+            else if (keyword == "ring" || keyword == "diamond") {
+                element.type = (uint16_t)(keyword == "ring" ? SceneElementType::HollowCircle : SceneElementType::HollowDiamond);
+                ok = static_cast<bool>(stream >> element.x0 >> element.y0 >> element.size >> element.stroke);
+            }
+            else if (keyword == "cornerbox" || keyword == "frame") {
+                element.type = (uint16_t)(keyword == "frame" ? SceneElementType::HollowRectangle : SceneElementType::CornerBox);
+                ok = static_cast<bool>(stream >> element.x0 >> element.y0 >> element.x1 >> element.y1 >> element.stroke);
+            }
+            else if (keyword == "rect") {
+                element.type = (uint16_t)SceneElementType::SolidRectangle;
+                ok = static_cast<bool>(stream >> element.x0 >> element.y0 >> element.x1 >> element.y1);
+            }
+            else if (keyword == "text") {
+                element.type = (uint16_t)SceneElementType::Text;
+                ok = static_cast<bool>(stream >> element.x0 >> element.y0 >> element.size);
+            }
+            else {
+                return Fail(error, lineNumber, "unknown element '" + keyword + "'");
+            }
+
+            std::string color;
+            if (!ok || !(stream >> color) || !ParseColor(color, &element.color))
+                return Fail(error, lineNumber, "malformed " + keyword);
+
+            if (element.type == (uint16_t)SceneElementType::Text) {
+                std::string text;
+                if (!ReadQuoted(stream, &text))
+                    return Fail(error, lineNumber, "text must be a double-quoted string");
+
+                element.textOffset = (uint32_t)(strings.size() * sizeof(char16_t));
+                if (!AppendUtf16(text, strings))
+                    return Fail(error, lineNumber, "text is not valid UTF-8");
+                element.textLength = (uint32_t)(strings.size() - element.textOffset / sizeof(char16_t));
+                strings.push_back(0);
+            }
+
+            std::string trailing;
+            if (stream >> trailing && trailing == "low") {
+                element.flags |= kSceneFlagLowPriority;
+                trailing.clear();
+                stream >> trailing;
+            }
+            if (!trailing.empty())
+                return Fail(error, lineNumber, "unexpected '" + trailing + "'");
+
+            elements.push_back(element);
+        }
+
+        SceneHeader header{};
+        memcpy(header.magic, "OVSC", 4);
+        header.version = kSceneVersion;
+        header.headerSize = sizeof(SceneHeader);
+        header.elementCount = (uint32_t)elements.size();
+        header.elementOffset = AlignUp(sizeof(SceneHeader));
+        header.stringOffset = AlignUp(header.elementOffset + elements.size() * sizeof(SceneElement));
+        header.stringBytes = (uint32_t)(strings.size() * sizeof(char16_t));
+        header.fileSize = AlignUp(header.stringOffset + header.stringBytes);
+        header.designWidth = designWidth;
+        header.designHeight = designHeight;
+
+        output.assign(header.fileSize, 0);
+        memcpy(output.data(), &header, sizeof(header));
+        if (!elements.empty())
+            memcpy(output.data() + header.elementOffset, elements.data(), elements.size() * sizeof(SceneElement));
+        if (!strings.empty())
+            memcpy(output.data() + header.stringOffset, strings.data(), header.stringBytes);
+
+        return true;
+    }
+
+    static bool CompileFile(const char* inputPath, const char* outputPath, std::string* error = nullptr) {
+        std::ifstream input(inputPath);
+        if (!input) return Fail(error, 0, std::string("cannot open ") + inputPath);
+
+        std::vector<uint8_t> output;
+        if (!Compile(input, output, error)) return false;
+
+        std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+        if (!out) return Fail(error, 0, std::string("cannot create ") + outputPath);
+
+        out.write(reinterpret_cast<const char*>(output.data()), (std::streamsize)output.size());
+        out.close();
+        if (!out) return Fail(error, 0, std::string("cannot write ") + outputPath);
+
+        return true;
+    }
+
+private:
+    static uint32_t AlignUp(size_t value) {
+        return (uint32_t)((value + kSceneAlignment - 1) & ~(size_t)(kSceneAlignment - 1));
+    }
+
+    static bool Fail(std::string* error, int lineNumber, const std::string& message) {
+        if (error) {
+            *error = lineNumber > 0 ? "line " + std::to_string(lineNumber) + ": " + message : message;
+        }
+        return false;
+    }
+
+    // A '#' at the start of a token starts a comment, unless the token is a color literal
+    // (exactly 6 or 8 hex digits) or inside a string. Inside a string a backslash escapes
+    // the next character, as in ReadQuoted.
+    static size_t FindComment(const std::string& line) {
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (quoted && line[i] == '\\') ++i;
+            else if (line[i] == '"') quoted = !quoted;
+            else if (line[i] == '#' && !quoted && (i == 0 || isspace((unsigned char)line[i - 1]))) {
+                size_t end = i + 1;
+                while (end < line.size() && isxdigit((unsigned char)line[end])) ++end;
+
+                size_t digits = end - i - 1;
+                bool delimited = end == line.size() || isspace((unsigned char)line[end]);
+                if (!(delimited && (digits == 6 || digits == 8))) return i;
+            }
+        }
+        return std::string::npos;
+    }
+
+    static bool ParseColor(const std::string& text, uint32_t* color) {
+        if (text.size() != 7 && text.size() != 9) return false;
+        if (text[0] != '#') return false;
+
+        // strtoul alone would take signs and whitespace
+        for (size_t i = 1; i < text.size(); ++i) {
+            if (!isxdigit((unsigned char)text[i])) return false;
+        }
+
+        unsigned long value = strtoul(text.c_str() + 1, nullptr, 16);
+        *color = text.size() == 7 ? (uint32_t)((value << 8) | 0xFF) : (uint32_t)value;
+        return true;
+    }
+
+    static bool ReadQuoted(std::istream& stream, std::string* text) {
+        stream >> std::ws;
+        if (stream.get() != '"') return false;
+
+        text->clear();
+        int c;
+        while ((c = stream.get()) != std::istream::traits_type::eof()) {
+            if (c == '"') return true;
+            if (c == '\\') {
+                c = stream.get();
+                if (c == std::istream::traits_type::eof()) return false;
+            }
+            text->push_back((char)c);
+        }
+        return false;
+    }
+
+    static bool AppendUtf16(const std::string& utf8, std::vector<char16_t>& out) {
+        size_t i = 0;
+        while (i < utf8.size()) {
+            uint32_t c = (unsigned char)utf8[i];
+            int extra = c < 0x80 ? 0 : (c & 0xE0) == 0xC0 ? 1 : (c & 0xF0) == 0xE0 ? 2 : (c & 0xF8) == 0xF0 ? 3 : -1;
+            if (extra < 0 || i + extra >= utf8.size()) return false;
+
+            if (extra > 0) c &= 0x3F >> extra;
+            for (int k = 1; k <= extra; ++k) {
+                unsigned char next = (unsigned char)utf8[i + k];
+                if ((next & 0xC0) != 0x80) return false;
+                c = (c << 6) | (next & 0x3F);
+            }
+            i += extra + 1;
+
+            if (c >= 0x10000) {
+                c -= 0x10000;
+                out.push_back((char16_t)(0xD800 + (c >> 10)));
+                out.push_back((char16_t)(0xDC00 + (c & 0x3FF)));
+            }
+            else {
+                out.push_back((char16_t)c);
+            }
+        }
+        return true;
+    }
+};
@@ -1,14 +1,35 @@
 #include <windows.h>
 #include <dwmapi.h>
 #include <d2d1.h>
+#include <d2d1_3.h>
 #include <d2d1helper.h>
 #include <dwrite.h>
 #include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "CommandList.hpp"
+#include "FrameDelta.hpp"
+#include "FrameScheduler.hpp"
+#include "ImageAtlas.hpp"
+#include "InputLatency.hpp"
+#include "OverlayScene.hpp"
+#include "PaneLayout.hpp"
+#include "QualityGovernor.hpp"
+#include "SpatialGrid.hpp"
+#include "StampCache.hpp"
+#include "StartupPipeline.hpp"
+#include "TimeSeries.hpp"
 
 #pragma comment(lib, "d2d1.lib")
 #pragma comment(lib, "dwrite.lib")
 #pragma comment(lib, "dwmapi.lib")
 
+enum class PlotStyle {
+    Line, // Polyline through each column's min and max
+    Band, // Filled min/max envelope
+};
+
 class OverlayWindow {
 public:
     // Changed callback signature to pass pointer to the class
@@ -23,14 +44,41 @@ public:
         m_pTextFormatEnglish(nullptr),
         m_pOutlineBrush(nullptr),
         m_pOutline2Brush(nullptr),
+        m_pStampBitmap(nullptr),
+        m_stampGeneration(0),
+        m_pSpriteContext(nullptr),
+        m_pSpriteBatch(nullptr),
+        m_batchStamps(false),
+        m_paneClipped(false),
+        m_pImageBitmap(nullptr),
+        m_imageGeneration(0),
+        m_pPipeline(nullptr),
+        m_pending(),
+        m_deviceReady(false),
+        m_deviceFailed(false),
         m_drawCallback(nullptr),
+        m_pScene(nullptr),
         m_relativeMouseX(-1),
         m_relativeMouseY(-1),
-        m_cursorVisible(true) {
+        m_cursorVisible(true),
+        m_inputTimeUs(0),
+        m_frameStartUs(0),
+        m_predictionHorizonUs(0),
+        m_predictMotion(false),
+        m_lastFrameUs(0),
+        m_antialiasMode(D2D1_ANTIALIAS_MODE_PER_PRIMITIVE),
+        m_taskSliceUs(2000),
+        m_labelGrid(32.0f),
+        m_hoverGrid(32.0f) {
         SetRectEmpty(&m_thumbnailRect);
     }
 
     ~OverlayWindow() {
+        // Background device creation writes into m_pending, let it finish first. Every task
+        // is waited for: when one fails the final task fails at once while others may still run.
+        if (m_pPipeline && !m_deviceReady) {
+            for (StartupPipeline::TaskId task : m_deviceTasks) m_pPipeline->Wait(task);
+        }
         CleanupD2D();
 
         if (m_overlayWindow) {
@@ -39,7 +87,10 @@ public:
         }
     }
 
-    bool Create() {
+    // Without a pipeline the device and font resources are created synchronously.
+    // With one they are created on its workers and the overlay starts drawing on the
+    // first Render() after they are ready; the pipeline must outlive the overlay.
+    bool Create(StartupPipeline* pipeline = nullptr) {
         WNDCLASSEXA wcex{};
         wcex.cbSize = sizeof(WNDCLASSEXA);
         wcex.style = CS_HREDRAW | CS_VREDRAW;
@@ -60,14 +111,29 @@ public:
         ShowWindow(m_overlayWindow, 1);
         UpdateWindow(m_overlayWindow);
 
+        if (pipeline) {
+            m_pPipeline = pipeline;
+            ScheduleDeviceD2D(*pipeline);
+            return true;
+        }
+
         if (!CreateDeviceD2D()) {
             CleanupD2D();
             return false;
         }
 
+        m_deviceReady = true;
         return true;
     }
 
+    bool IsDeviceReady() const {
+        return m_deviceReady;
+    }
+
+    bool IsDeviceFailed() const {
+        return m_deviceFailed;
+    }
+
     void UpdatePosition(const RECT& thumbnailRect) {
         m_thumbnailRect = thumbnailRect;
 
@@ -87,6 +153,10 @@ public:
                 D2D1_SIZE_U size = m_pRenderTarget->GetPixelSize();
                 if (size.width != width || size.height != height) {
                     // Release resources before resize
+                    SafeRelease(&m_pStampBitmap);
+                    SafeRelease(&m_pImageBitmap);
+                    SafeRelease(&m_pSpriteBatch);
+                    SafeRelease(&m_pSpriteContext);
                     SafeRelease(&m_pOutline2Brush);
                     SafeRelease(&m_pOutlineBrush);
                     SafeRelease(&m_pRenderTarget);
@@ -106,33 +176,352 @@ public:
         m_drawCallback = callback;
     }
 
-    void UpdateMouseInfo(const POINT& relativeMousePos, bool visible) {
+    // Draws what follows in another clone pane. Draw code works in pane 0 pixels, which the
+    // overlay covers; the transform (CloneWindow::GetPaneTransform) moves them onto the same
+    // source content in that pane and clips to it. Only the part of a pane that lies over pane 0
+    // can show. nullptr goes back to pane 0; Render() does that after the draw callback.
+    void SetPaneSpace(const PaneTransform* transform) {
+        if (!m_pRenderTarget) return;
+        FlushStamps();
+        if (m_paneClipped) m_pRenderTarget->PopAxisAlignedClip();
+        m_paneClipped = false;
+        m_pRenderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
+        if (!transform) return;
+
+        const PaneRect& clip = transform->clip;
+        m_pRenderTarget->PushAxisAlignedClip(D2D1::RectF((float)clip.left, (float)clip.top,
+            (float)clip.right, (float)clip.bottom), D2D1_ANTIALIAS_MODE_ALIASED);
+        m_paneClipped = true;
+        m_pRenderTarget->SetTransform(D2D1::Matrix3x2F(transform->scaleX, 0.0f, 0.0f,
+            transform->scaleY, transform->offsetX, transform->offsetY));
+    }
+
+    // The scene is not copied; it must stay mapped until it is replaced or cleared with nullptr
+    void SetScene(const OverlaySceneView* scene) {
+        m_pScene = (scene && scene->IsValid()) ? scene : nullptr;
+    }
+
+    // sampleTimeUs is when the position was read; pass it from before GetCursorPos for accurate latency
+    void UpdateMouseInfo(const POINT& relativeMousePos, bool visible, int64_t sampleTimeUs = LatencyClock::NowUs()) {
         m_relativeMouseX = relativeMousePos.x;
         m_relativeMouseY = relativeMousePos.y;
         m_cursorVisible = visible;
+        m_inputTimeUs = sampleTimeUs;
+
+        if (relativeMousePos.x >= 0 && relativeMousePos.y >= 0 && visible) {
+            m_cursorPredictor.AddSample(sampleTimeUs, (float)relativeMousePos.x, (float)relativeMousePos.y);
+        }
+        else {
+            m_cursorPredictor.Reset();
+        }
     }
 
-    void Render() {
-        if (!m_pRenderTarget) return;
+    // Extrapolates the cursor and tracked elements toward the expected display time
+    void SetMotionPrediction(bool enabled) {
+        m_predictMotion = enabled;
+        if (!enabled) m_motionTracks.clear();
+    }
+
+    // Call from the draw callback with an element's current position each frame; returns
+    // where it is expected to be when the frame is displayed. trackId must be stable.
+    D2D1_POINT_2F PredictPosition(uint32_t trackId, D2D1_POINT_2F position) {
+        if (!m_predictMotion) return position;
+
+        MotionPredictor& track = m_motionTracks[trackId];
+        track.AddSample(m_frameStartUs, position.x, position.y);
+
+        MotionPredictor::Point predicted = track.Predict(m_frameStartUs + m_predictionHorizonUs);
+        return D2D1::Point2F(predicted.x, predicted.y);
+    }
+
+    // From input sampling to the return of EndDraw
+    const LatencyStats& GetInputToPresentLatency() const {
+        return m_inputToPresent;
+    }
+
+    // From input sampling to the estimated scan-out of the DWM frame that shows it
+    const LatencyStats& GetInputToPhotonLatency() const {
+        return m_inputToPhoton;
+    }
+
+    // Frame time (frame start through Flush(), excluding the present in EndDraw) the quality
+    // governor keeps the overlay under
+    void SetFrameBudget(int64_t budgetUs) {
+        QualityGovernorConfig config = m_governor.GetConfig();
+        config.budgetUs = budgetUs;
+        m_governor.SetConfig(config);
+    }
+
+    QualityTier GetQualityTier() const {
+        return m_governor.GetTier();
+    }
+
+    // Microseconds until Render() will draw again under the governor's refresh cap, 0 when
+    // a frame is due now. The frame loop sleeps this long instead of spinning.
+    int64_t GetTimeUntilNextFrameUs() const {
+        int64_t intervalUs = m_governor.GetMinFrameIntervalUs();
+        if (!intervalUs || !m_lastFrameUs) return 0;
+
+        int64_t remainingUs = m_lastFrameUs + intervalUs - LatencyClock::NowUs();
+        return remainingUs > 0 ? remainingUs : 0;
+    }
+
+    // Draw callbacks should skip optional content when this returns false
+    bool ShouldDrawLowPriority() const {
+        return !m_governor.IsAtLeast(QualityTier::EssentialOnly);
+    }
+
+    // Declutters labels: tries the four corners around the anchor in turn and draws the
+    // text at the first one that overlaps no label already placed this frame. Labels drawn
+    // earlier win, so call in priority order. Returns false when the label was dropped.
+    bool DrawLabel(const wchar_t* text, D2D1_POINT_2F anchor, float fontSize, D2D1::ColorF textColor) {
+        D2D1_SIZE_F size = GetTextSize(text, fontSize);
+        if (size.width <= 0.0f || size.height <= 0.0f) return false;
+
+        // Room for the outline rings around the glyphs
+        const float padding = 2.0f;
+        const float offsetX[] = { 0.0f, 0.0f, -size.width, -size.width };
+        const float offsetY[] = { 0.0f, -size.height, 0.0f, -size.height };
+
+        for (int i = 0; i < 4; ++i) {
+            float left = anchor.x + offsetX[i];
+            float top = anchor.y + offsetY[i];
+            SpatialRect rect = { left - padding, top - padding, left + size.width + padding, top + size.height + padding };
+            if (m_labelGrid.AnyOverlap(rect)) continue;
+
+            m_labelGrid.Insert(rect, 0);
+            DrawTextWithOutline(text, D2D1::Point2F(left, top), fontSize, textColor);
+            return true;
+        }
+
+        return false;
+    }
+
+    // Registers a hover area for this frame; call from the draw callback for every element
+    // that should respond to the mouse. Areas not registered again in the next frame expire.
+    void AddHoverTarget(uint32_t id, D2D1_RECT_F rect) {
+        SpatialRect area = { rect.left, rect.top, rect.right, rect.bottom };
+
+        auto it = m_hoverTargets.find(id);
+        if (it != m_hoverTargets.end() && m_hoverGrid.IsLive(it->second) && m_hoverGrid.GetUserId(it->second) == id) {
+            m_hoverGrid.Move(it->second, area);
+            return;
+        }
+
+        m_hoverTargets[id] = m_hoverGrid.Insert(area, id);
+    }
+
+    // The hover target under the mouse; the most recently registered one wins where they overlap
+    bool GetHoveredTarget(uint32_t* id) const {
+        if (m_relativeMouseX < 0 || m_relativeMouseY < 0 || !m_cursorVisible) return false;
+
+        int width = m_thumbnailRect.right - m_thumbnailRect.left;
+        int height = m_thumbnailRect.bottom - m_thumbnailRect.top;
+        float pixelX = (m_relativeMouseX * width) / 1000.0f;
+        float pixelY = (m_relativeMouseY * height) / 1000.0f;
+
+        SpatialGrid::Handle handle = m_hoverGrid.HitTest(pixelX, pixelY);
+        if (handle == SpatialGrid::kInvalidHandle) return false;
+
+        if (id) *id = m_hoverGrid.GetUserId(handle);
+        return true;
+    }
+
+    // Plots the newest sampleCount samples into rect with one pixel column per x pixel and
+    // a single geometry draw. minValue >= maxValue scales to the plotted samples.
+    void DrawPlot(TimeSeriesPlot& plot, D2D1_RECT_F rect, size_t sampleCount, float minValue, float maxValue,
+        PlotStyle style, float strokeWidth, D2D1::ColorF color) {
+        if (!m_pRenderTarget || !m_pD2DFactory) return;
+
+        plot.Update();
+
+        size_t columns = (size_t)(std::max)(rect.right - rect.left, 0.0f);
+        if (columns < 2) return;
+
+        m_plotMins.resize(columns);
+        m_plotMaxs.resize(columns);
+        if (!plot.Decimate(sampleCount, columns, m_plotMins.data(), m_plotMaxs.data())) return;
+
+        if (!(maxValue > minValue)) {
+            plot.GetRange(sampleCount, &minValue, &maxValue);
+            if (!(maxValue > minValue)) {
+                minValue -= 1.0f;
+                maxValue += 1.0f;
+            }
+        }
+
+        float scale = (rect.bottom - rect.top) / (maxValue - minValue);
+        auto toY = [&](float value) {
+            return rect.bottom - ((std::min)((std::max)(value, minValue), maxValue) - minValue) * scale;
+        };
+
+        m_plotPoints.clear();
+        if (style == PlotStyle::Band) {
+            // Along the maxima left to right, back along the minima; at least a pixel thick
+            m_plotPoints.resize(columns * 2);
+            for (size_t column = 0; column < columns; ++column) {
+                float x = rect.left + column + 0.5f;
+                float top = toY(m_plotMaxs[column]);
+                float bottom = toY(m_plotMins[column]);
+                if (bottom - top < 1.0f) {
+                    float middle = (top + bottom) * 0.5f;
+                    top = middle - 0.5f;
+                    bottom = middle + 0.5f;
+                }
+                m_plotPoints[column] = D2D1::Point2F(x, top);
+                m_plotPoints[columns * 2 - 1 - column] = D2D1::Point2F(x, bottom);
+            }
+        }
+        else {
+            // Each column's vertical span starts at the end nearer the previous point
+            float lastY = toY(m_plotMins[0]);
+            for (size_t column = 0; column < columns; ++column) {
+                float x = rect.left + column + 0.5f;
+                float top = toY(m_plotMaxs[column]);
+                float bottom = toY(m_plotMins[column]);
+                bool downward = std::fabs(lastY - top) <= std::fabs(lastY - bottom);
+
+                m_plotPoints.push_back(D2D1::Point2F(x, downward ? top : bottom));
+                if (top != bottom) m_plotPoints.push_back(D2D1::Point2F(x, downward ? bottom : top));
+                lastY = m_plotPoints.back().y;
+            }
+        }
+
+        ID2D1PathGeometry* pGeometry = nullptr;
+        if (FAILED(m_pD2DFactory->CreatePathGeometry(&pGeometry))) return;
+
+        ID2D1GeometrySink* pSink = nullptr;
+        if (SUCCEEDED(pGeometry->Open(&pSink))) {
+            pSink->BeginFigure(m_plotPoints[0], style == PlotStyle::Band ? D2D1_FIGURE_BEGIN_FILLED : D2D1_FIGURE_BEGIN_HOLLOW);
+            pSink->AddLines(m_plotPoints.data() + 1, (UINT32)(m_plotPoints.size() - 1));
+            pSink->EndFigure(style == PlotStyle::Band ? D2D1_FIGURE_END_CLOSED : D2D1_FIGURE_END_OPEN);
+
+            if (SUCCEEDED(pSink->Close())) {
+                ID2D1SolidColorBrush* pPlotBrush = nullptr;
+                m_pRenderTarget->CreateSolidColorBrush(color, &pPlotBrush);
+                if (pPlotBrush) {
+                    if (style == PlotStyle::Band) m_pRenderTarget->FillGeometry(pGeometry, pPlotBrush);
+                    else m_pRenderTarget->DrawGeometry(pGeometry, pPlotBrush, strokeWidth);
+                    pPlotBrush->Release();
+                }
+            }
+            pSink->Release();
+        }
+
+        pGeometry->Release();
+    }
+
+    // Draws a frame of primitives, e.g. one decoded by FrameDeltaDecoder, in overlay pixels
+    void DrawPrimitives(const std::vector<OverlayPrimitive>& primitives) {
+        if (!m_pRenderTarget || primitives.empty()) return;
+
+        // One brush for the whole frame, recolored per primitive
+        ID2D1SolidColorBrush* pBrush = nullptr;
+        if (FAILED(m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &pBrush))) return;
+
+        m_batchStamps = true;
+        for (const OverlayPrimitive& primitive : primitives) {
+            if ((primitive.flags & kSceneFlagLowPriority) && !ShouldDrawLowPriority()) continue;
+
+            DrawElement((SceneElementType)primitive.type, primitive.color,
+                D2D1::Point2F(primitive.x0, primitive.y0), D2D1::Point2F(primitive.x1, primitive.y1),
+                primitive.size, primitive.stroke, primitive.text.c_str(), pBrush);
+        }
+        FlushStamps();
+        m_batchStamps = false;
+
+        pBrush->Release();
+    }
+
+    // Coroutines spawned here run on the render thread before each frame is drawn
+    FrameScheduler& GetScheduler() {
+        return m_scheduler;
+    }
+
+    // Time per frame the scheduler may spend resuming tasks
+    void SetTaskSlice(int64_t sliceUs) {
+        m_taskSliceUs = sliceUs;
+    }
+
+    // Draw jobs run in parallel before each frame, each recording into its own CommandList;
+    // the merged commands are drawn after the scene, below the draw callback's content.
+    // Jobs run on worker threads and must not touch the overlay. Returns the job index.
+    size_t AddDrawJob(ParallelRecorder::Job job, int32_t z = 0) {
+        return m_recorder.AddJob(std::move(job), z);
+    }
+
+    void ClearDrawJobs() {
+        m_recorder.ClearJobs();
+        m_recordedFrame.clear();
+    }
+
+    // Commands recorded for the latest frame, e.g. to feed a FrameDeltaEncoder
+    const std::vector<OverlayPrimitive>& GetRecordedFrame() const {
+        return m_recordedFrame;
+    }
+
+    // Returns true when a frame was drawn and presented
+    bool Render() {
+        // Gate the first frame on background device creation
+        if (!m_deviceReady) {
+            if (!AdoptDeviceD2D()) return false;
+            UpdatePosition(m_thumbnailRect);
+        }
+
+        if (!m_pRenderTarget) return false;
 
         int width = m_thumbnailRect.right - m_thumbnailRect.left;
         int height = m_thumbnailRect.bottom - m_thumbnailRect.top;
 
+        // Refresh cap from the quality governor
+        int64_t nowUs = LatencyClock::NowUs();
+        int64_t intervalUs = m_governor.GetMinFrameIntervalUs();
+        if (intervalUs && nowUs - m_lastFrameUs < intervalUs) return false;
+
+        m_lastFrameUs = nowUs;
+        m_frameStartUs = nowUs;
+        m_predictionHorizonUs = m_predictMotion ? GetExpectedLatencyUs() : 0;
+        PruneMotionTracks();
+        BeginSpatialFrame();
+
+        // Frame-spread work first so the draw callback sees its latest results
+        m_scheduler.RunFrame(m_taskSliceUs);
+
+        // Record draw jobs before BeginDraw so Direct2D is only ever touched from this thread
+        if (m_recorder.GetJobCount()) m_recorder.Record(width, height, m_recordedFrame);
+
         m_pRenderTarget->BeginDraw();
         m_pRenderTarget->Clear(D2D1::ColorF(D2D1::ColorF::Black, 0.0f)); // Transparent
 
+        // Draw static scene content
+        if (m_pScene) DrawScene(*m_pScene, width, height);
+
+        // Draw recorded job content
+        DrawPrimitives(m_recordedFrame);
+
         // Draw user-defined content
         if (m_drawCallback) m_drawCallback(this, width, height);
+        SetPaneSpace(nullptr);
 
         // Draw cursor
         DrawCustomCursor();
 
-        HRESULT hr = m_pRenderTarget->EndDraw();
+        // Direct2D batches the drawing and does most of the work when it is flushed, so the
+        // frame is timed through Flush(). The present in EndDraw is left out: it blocks until
+        // the next vblank, which would read as load at any budget below the refresh interval.
+        HRESULT hr = m_pRenderTarget->Flush();
+        m_governor.AddFrame(LatencyClock::NowUs() - m_frameStartUs);
+
+        HRESULT endHr = m_pRenderTarget->EndDraw();
+        if (SUCCEEDED(hr)) hr = endHr;
+        RecordPresentLatency();
 
         // If the render target was lost, recreate it
         if (hr == D2DERR_RECREATE_TARGET) {
             UpdatePosition(m_thumbnailRect);
         }
+
+        return SUCCEEDED(hr);
     }
 
     // Drawing utility functions
@@ -167,15 +556,18 @@ public:
             }
         }
 
+        // The faint outer ring is the first thing dropped under load
         outlineOffset = 2.0f;
-        for (float x = -outlineOffset; x <= outlineOffset; x += outlineOffset) {
-            for (float y = -outlineOffset; y <= outlineOffset; y += outlineOffset) {
-                if (x != 0.0f || y != 0.0f) {
-                    D2D1_POINT_2F outlinePoint = D2D1::Point2F(origin.x + x, origin.y + y);
-                    m_pRenderTarget->DrawTextLayout(
-                        outlinePoint,
-                        pTextLayout,
-                        m_pOutline2Brush);
+        if (!m_governor.IsAtLeast(QualityTier::NoOuterOutline)) {
+            for (float x = -outlineOffset; x <= outlineOffset; x += outlineOffset) {
+                for (float y = -outlineOffset; y <= outlineOffset; y += outlineOffset) {
+                    if (x != 0.0f || y != 0.0f) {
+                        D2D1_POINT_2F outlinePoint = D2D1::Point2F(origin.x + x, origin.y + y);
+                        m_pRenderTarget->DrawTextLayout(
+                            outlinePoint,
+                            pTextLayout,
+                            m_pOutline2Brush);
+                    }
                 }
             }
         }
@@ -193,6 +585,8 @@ public:
         if (!m_pRenderTarget) return;
         if (!(startPoint.x - endPoint.x) && !(startPoint.y - endPoint.y)) return;
 
+        SetShapeAntialias(FLT_MAX);
+
         ID2D1SolidColorBrush* pLineBrush = nullptr;
         m_pRenderTarget->CreateSolidColorBrush(color, &pLineBrush);
         m_pRenderTarget->DrawLine(startPoint, endPoint, pLineBrush, strokeWidth);
@@ -203,6 +597,8 @@ public:
     void DrawSolidCircle(D2D1_POINT_2F center, float radius, D2D1::ColorF color) {
         if (!m_pRenderTarget) return;
 
+        SetShapeAntialias(radius * 2);
+
         ID2D1SolidColorBrush* pCircleBrush = nullptr;
         m_pRenderTarget->CreateSolidColorBrush(color, &pCircleBrush);
         m_pRenderTarget->FillEllipse(D2D1::Ellipse(center, radius, radius), pCircleBrush);
@@ -213,6 +609,8 @@ public:
     void DrawHollowCircle(D2D1_POINT_2F center, float radius, float strokeWidth, D2D1::ColorF color) {
         if (!m_pRenderTarget) return;
 
+        SetShapeAntialias(radius * 2);
+
         ID2D1SolidColorBrush* pCircleBrush = nullptr;
         m_pRenderTarget->CreateSolidColorBrush(color, &pCircleBrush);
         m_pRenderTarget->DrawEllipse(D2D1::Ellipse(center, radius, radius), pCircleBrush, strokeWidth);
@@ -229,6 +627,8 @@ public:
         D2D1_POINT_2F bottom = { center.x, center.y + radius };
         D2D1_POINT_2F left = { center.x - radius, center.y };
 
+        SetShapeAntialias(radius * 2);
+
         // Create brush
         ID2D1SolidColorBrush* pDiamondBrush = nullptr;
         m_pRenderTarget->CreateSolidColorBrush(color, &pDiamondBrush);
@@ -274,6 +674,129 @@ public:
         DrawLine({ BottomLeft.x, LeftTwoThirds }, BottomLeft, lineWidth, color);
     }
 
+    // Draws a marker from the stamp cache; shapes too large to stamp are drawn as geometry.
+    // For circles and diamonds halfWidth is the radius and halfHeight is ignored.
+    void DrawStamp(StampShape shape, D2D1_POINT_2F center, float halfWidth, float halfHeight, float strokeWidth, D2D1::ColorF color) {
+        if (!m_pRenderTarget) return;
+
+        if (shape != StampShape::CornerBox) halfHeight = halfWidth;
+
+        // A miss may repack the atlas under the queued stamps, so those are drawn first
+        StampKey key = StampCache::MakeKey(shape, halfWidth, halfHeight, strokeWidth);
+        if (!m_stampCache.Peek(key)) FlushStamps();
+
+        const Stamp* stamp = m_stampCache.Find(key);
+        if (!stamp || !UploadStamps()) {
+            FlushStamps();
+            DrawStampGeometry(shape, center, halfWidth, halfHeight, strokeWidth, color);
+            return;
+        }
+
+        // Fractional destinations are resampled by the linear filter, giving sub-pixel placement
+        StampSprite sprite;
+        float left = center.x - stamp->originX;
+        float top = center.y - stamp->originY;
+        sprite.destination = D2D1::RectF(left, top, left + stamp->rect.width, top + stamp->rect.height);
+        sprite.source = D2D1::RectU(stamp->rect.x, stamp->rect.y, stamp->rect.x + stamp->rect.width, stamp->rect.y + stamp->rect.height);
+        sprite.color = color;
+        m_stampRun.push_back(sprite);
+
+        if (!m_batchStamps) FlushStamps();
+    }
+
+    // Adds an image to the overlay's atlas; see ImageAtlas::AddImage for the pixel format
+    ImageId AddImage(const uint32_t* pixels, int width, int height, size_t stride, bool premultiplied = false) {
+        return m_imageAtlas.AddImage(pixels, width, height, stride, premultiplied);
+    }
+
+    // Adds an icon at the given size (0 uses its own size). Icons without an alpha
+    // channel take their transparency from the mask.
+    ImageId AddIconImage(HICON hIcon, int size = 0) {
+        ICONINFO iconInfo = {};
+        if (!hIcon || !GetIconInfo(hIcon, &iconInfo)) return kInvalidImage;
+
+        BITMAP bitmap = {};
+        GetObject(iconInfo.hbmColor ? iconInfo.hbmColor : iconInfo.hbmMask, sizeof(bitmap), &bitmap);
+        int width = size ? size : bitmap.bmWidth;
+        int height = size ? size : (iconInfo.hbmColor ? bitmap.bmHeight : bitmap.bmHeight / 2);
+
+        if (iconInfo.hbmColor) DeleteObject(iconInfo.hbmColor);
+        if (iconInfo.hbmMask) DeleteObject(iconInfo.hbmMask);
+        if (width <= 0 || height <= 0) return kInvalidImage;
+
+        // Render the icon once into a top-down 32-bit DIB with and without its mask applied
+        BITMAPINFO info = {};
+        info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        info.bmiHeader.biWidth = width;
+        info.bmiHeader.biHeight = -height;
+        info.bmiHeader.biPlanes = 1;
+        info.bmiHeader.biBitCount = 32;
+        info.bmiHeader.biCompression = BI_RGB;
+
+        void* bits = nullptr;
+        HDC hdc = CreateCompatibleDC(nullptr);
+        HBITMAP hDib = CreateDIBSection(hdc, &info, DIB_RGB_COLORS, &bits, nullptr, 0);
+        if (!hdc || !hDib) {
+            if (hDib) DeleteObject(hDib);
+            if (hdc) DeleteDC(hdc);
+            return kInvalidImage;
+        }
+
+        HGDIOBJ hOld = SelectObject(hdc, hDib);
+        std::vector<uint32_t> pixels((size_t)width * height);
+        uint32_t* dib = static_cast<uint32_t*>(bits);
+
+        std::fill(dib, dib + pixels.size(), 0u);
+        DrawIconEx(hdc, 0, 0, hIcon, width, height, 0, nullptr, DI_NORMAL);
+        GdiFlush();
+        std::copy(dib, dib + pixels.size(), pixels.begin());
+
+        bool hasAlpha = std::any_of(pixels.begin(), pixels.end(), [](uint32_t pixel) { return (pixel >> 24) != 0; });
+        if (!hasAlpha) {
+            // The mask is white where the icon is transparent
+            std::fill(dib, dib + pixels.size(), 0u);
+            DrawIconEx(hdc, 0, 0, hIcon, width, height, 0, nullptr, DI_MASK);
+            GdiFlush();
+            for (size_t i = 0; i < pixels.size(); ++i) {
+                pixels[i] = (dib[i] & 0x00FFFFFF) ? 0 : (pixels[i] | 0xFF000000);
+            }
+        }
+
+        SelectObject(hdc, hOld);
+        DeleteObject(hDib);
+        DeleteDC(hdc);
+
+        // Drawing onto transparent black leaves the colors premultiplied
+        return m_imageAtlas.AddImage(pixels.data(), width, height, (size_t)width * sizeof(uint32_t), true);
+    }
+
+    // Draws an atlas image scaled into rect with one blit from the mip level that fits
+    void DrawImage(ImageId id, D2D1_RECT_F rect, float opacity = 1.0f) {
+        if (!m_pRenderTarget || !UploadImages()) return;
+
+        StampRect level;
+        if (!m_imageAtlas.GetLevel(id, m_imageAtlas.SelectLevel(id, rect.right - rect.left, rect.bottom - rect.top), &level)) return;
+
+        D2D1_RECT_F source = D2D1::RectF(
+            (float)level.x,
+            (float)level.y,
+            (float)(level.x + level.width),
+            (float)(level.y + level.height));
+
+        m_pRenderTarget->DrawBitmap(m_pImageBitmap, rect, opacity, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, source);
+    }
+
+    // Draws an image centred on center, fitted into a size x size square keeping its aspect ratio
+    void DrawIcon(ImageId id, D2D1_POINT_2F center, float size, float opacity = 1.0f) {
+        int width, height;
+        if (!m_imageAtlas.GetImageSize(id, &width, &height)) return;
+
+        float scale = size / (std::max)(width, height);
+        float halfWidth = width * scale * 0.5f;
+        float halfHeight = height * scale * 0.5f;
+        DrawImage(id, D2D1::RectF(center.x - halfWidth, center.y - halfHeight, center.x + halfWidth, center.y + halfHeight), opacity);
+    }
+
     D2D1_SIZE_F GetTextSize(const wchar_t* text, float fontSize) {
         if (!m_pDWriteFactory || !m_pTextFormatEnglish) return D2D1::SizeF(0, 0);
 
@@ -300,6 +823,8 @@ public:
     void DrawSolidRectangle(D2D1_RECT_F rect, D2D1::ColorF color) {
         if (!m_pRenderTarget) return;
 
+        SetShapeAntialias((std::max)(rect.right - rect.left, rect.bottom - rect.top));
+
         ID2D1SolidColorBrush* pRectBrush = nullptr;
         m_pRenderTarget->CreateSolidColorBrush(color, &pRectBrush);
         m_pRenderTarget->FillRectangle(rect, pRectBrush);
@@ -310,6 +835,8 @@ public:
     void DrawHollowRectangle(D2D1_RECT_F rect, float strokeWidth, D2D1::ColorF color) {
         if (!m_pRenderTarget) return;
 
+        SetShapeAntialias((std::max)(rect.right - rect.left, rect.bottom - rect.top));
+
         ID2D1SolidColorBrush* pRectBrush = nullptr;
         m_pRenderTarget->CreateSolidColorBrush(color, &pRectBrush);
         m_pRenderTarget->DrawRectangle(rect, pRectBrush, strokeWidth);
@@ -330,11 +857,80 @@ private:
     ID2D1SolidColorBrush* m_pOutlineBrush;
     ID2D1SolidColorBrush* m_pOutline2Brush;
 
+    // Stamp atlas, mirrored into m_pStampBitmap
+    StampCache m_stampCache;
+    ID2D1Bitmap* m_pStampBitmap;
+    uint32_t m_stampGeneration;
+
+    // Stamps queued while m_batchStamps is set, drawn together by FlushStamps().
+    // Sprite batches need ID2D1DeviceContext3 (Windows 10 1607); both are null without it.
+    struct StampSprite {
+        D2D1_RECT_F destination;
+        D2D1_RECT_U source;
+        D2D1_COLOR_F color;
+    };
+    ID2D1DeviceContext3* m_pSpriteContext;
+    ID2D1SpriteBatch* m_pSpriteBatch;
+    std::vector<StampSprite> m_stampRun;
+    bool m_batchStamps;
+    bool m_paneClipped; // SetPaneSpace pushed a clip that is still in place
+
+    // Image atlas with mip chains, mirrored into m_pImageBitmap
+    ImageAtlas m_imageAtlas;
+    ID2D1Bitmap* m_pImageBitmap;
+    uint32_t m_imageGeneration;
+
+    // Deferred device creation; m_pending is only written by pipeline tasks until all of m_deviceTasks are done
+    struct PendingDevice {
+        ID2D1Factory* pD2DFactory;
+        IDWriteFactory* pDWriteFactory;
+        IDWriteTextFormat* pTextFormat;
+    };
+    StartupPipeline* m_pPipeline;
+    std::vector<StartupPipeline::TaskId> m_deviceTasks; // The last one depends on all the others
+    PendingDevice m_pending;
+    bool m_deviceReady;
+    bool m_deviceFailed;
+
     DrawCallback m_drawCallback;
+    const OverlaySceneView* m_pScene;
     int m_relativeMouseX;  // Mouse X position (0-1000 range)
     int m_relativeMouseY;  // Mouse Y position (0-1000 range)
     bool m_cursorVisible;
 
+    // Input-to-photon latency and motion prediction
+    int64_t m_inputTimeUs;
+    int64_t m_frameStartUs;
+    int64_t m_predictionHorizonUs;
+    bool m_predictMotion;
+    MotionPredictor m_cursorPredictor;
+    std::unordered_map<uint32_t, MotionPredictor> m_motionTracks;
+    LatencyStats m_inputToPresent;
+    LatencyStats m_inputToPhoton;
+
+    // Adaptive quality
+    QualityGovernor m_governor;
+    int64_t m_lastFrameUs;
+    D2D1_ANTIALIAS_MODE m_antialiasMode;
+
+    // Coroutines driven by the frame loop
+    FrameScheduler m_scheduler;
+    int64_t m_taskSliceUs;
+
+    // Label decluttering and hover lookup
+    SpatialGrid m_labelGrid;
+    SpatialGrid m_hoverGrid;
+    std::unordered_map<uint32_t, SpatialGrid::Handle> m_hoverTargets;
+
+    // Plot scratch, reused across frames
+    std::vector<float> m_plotMins;
+    std::vector<float> m_plotMaxs;
+    std::vector<D2D1_POINT_2F> m_plotPoints;
+
+    // Parallel draw jobs and their merged commands for the current frame
+    ParallelRecorder m_recorder;
+    std::vector<OverlayPrimitive> m_recordedFrame;
+
     void DrawCustomCursor() {
         // If relative mouse position is valid and cursor is visible
         if (m_relativeMouseX >= 0 && m_relativeMouseY >= 0 && m_cursorVisible && m_pRenderTarget) {
@@ -344,34 +940,204 @@ private:
 
             if (width <= 0 || height <= 0) return;
 
+            float relativeX = (float)m_relativeMouseX;
+            float relativeY = (float)m_relativeMouseY;
+            if (m_predictMotion && m_cursorPredictor.HasSamples()) {
+                MotionPredictor::Point predicted = m_cursorPredictor.Predict(m_inputTimeUs + m_predictionHorizonUs);
+                relativeX = predicted.x;
+                relativeY = predicted.y;
+            }
+
             // Convert relative position (0-1000) to pixel coordinates
-            float pixelX = (m_relativeMouseX * width) / 1000.0f;
-            float pixelY = (m_relativeMouseY * height) / 1000.0f;
+            float pixelX = (relativeX * width) / 1000.0f;
+            float pixelY = (relativeY * height) / 1000.0f;
+
+            m_batchStamps = true;
 
             // Draw filled circle
-            DrawSolidCircle(D2D1::Point2F(pixelX, pixelY), 5.0f, D2D1::ColorF(D2D1::ColorF::White));
+            DrawStamp(StampShape::SolidCircle, D2D1::Point2F(pixelX, pixelY), 5.0f, 5.0f, 0.0f, D2D1::ColorF(D2D1::ColorF::White));
 
             // Draw outline
-            DrawHollowCircle(D2D1::Point2F(pixelX, pixelY), 5.0f, 1.0f, D2D1::ColorF(D2D1::ColorF::Black));
+            DrawStamp(StampShape::HollowCircle, D2D1::Point2F(pixelX, pixelY), 5.0f, 5.0f, 1.0f, D2D1::ColorF(D2D1::ColorF::Black));
+
+            FlushStamps();
+            m_batchStamps = false;
         }
     }
 
-    bool CreateDeviceD2D() {
-        HRESULT hr;
+    // Shapes at most this many pixels across lose antialiasing at QualityTier::AliasedSmallShapes
+    static constexpr float kSmallShapeExtent = 12.0f;
+
+    void SetShapeAntialias(float extent) {
+        D2D1_ANTIALIAS_MODE mode = (extent <= kSmallShapeExtent && m_governor.IsAtLeast(QualityTier::AliasedSmallShapes))
+            ? D2D1_ANTIALIAS_MODE_ALIASED
+            : D2D1_ANTIALIAS_MODE_PER_PRIMITIVE;
+
+        if (mode != m_antialiasMode) {
+            m_pRenderTarget->SetAntialiasMode(mode);
+            m_antialiasMode = mode;
+        }
+    }
+
+    // Median measured latency, preferring the photon estimate; one 60 Hz frame until measured
+    int64_t GetExpectedLatencyUs() const {
+        const size_t kMinSamples = 16;
+        if (m_inputToPhoton.GetCount() >= kMinSamples) return m_inputToPhoton.Percentile(0.5);
+        if (m_inputToPresent.GetCount() >= kMinSamples) return m_inputToPresent.Percentile(0.5);
+        return 16667;
+    }
+
+    void PruneMotionTracks() {
+        for (auto it = m_motionTracks.begin(); it != m_motionTracks.end();) {
+            if (m_frameStartUs - it->second.GetLatestTime() > 500000) it = m_motionTracks.erase(it);
+            else ++it;
+        }
+    }
+
+    // Labels are placed from scratch each frame; hover targets persist for one extra frame
+    // so queries made during the draw callback see the previous frame's complete set
+    void BeginSpatialFrame() {
+        m_labelGrid.Clear();
+
+        // The id map only needs pruning when targets actually expired
+        if (m_hoverGrid.RemoveStale()) {
+            for (auto it = m_hoverTargets.begin(); it != m_hoverTargets.end();) {
+                if (!m_hoverGrid.IsLive(it->second) || m_hoverGrid.GetUserId(it->second) != it->first) it = m_hoverTargets.erase(it);
+                else ++it;
+            }
+        }
+        m_hoverGrid.BeginFrame();
+    }
+
+    void RecordPresentLatency() {
+        if (!m_inputTimeUs) return;
+
+        int64_t presentUs = LatencyClock::NowUs();
+        m_inputToPresent.Add(presentUs - m_inputTimeUs);
+
+        // DWM picks the presented frame up at the next vblank and scans it out one refresh later
+        DWM_TIMING_INFO timing = {};
+        timing.cbSize = sizeof(timing);
+        if (SUCCEEDED(DwmGetCompositionTimingInfo(NULL, &timing)) && timing.qpcRefreshPeriod) {
+            int64_t periodUs = LatencyClock::QpcToUs((int64_t)timing.qpcRefreshPeriod);
+            int64_t vblankUs = LatencyClock::QpcToUs((int64_t)timing.qpcVBlank);
+            if (periodUs > 0) {
+                int64_t refreshes = presentUs > vblankUs ? (presentUs - vblankUs + periodUs - 1) / periodUs : 0;
+                int64_t photonUs = vblankUs + (refreshes + 1) * periodUs;
+                m_inputToPhoton.Add(photonUs - m_inputTimeUs);
+            }
+        }
+    }
+
+    static D2D1::ColorF UnpackColor(uint32_t rgba) {
+        return D2D1::ColorF(
+            ((rgba >> 24) & 0xFF) / 255.0f,
+            ((rgba >> 16) & 0xFF) / 255.0f,
+            ((rgba >> 8) & 0xFF) / 255.0f,
+            (rgba & 0xFF) / 255.0f);
+    }
+
+    void DrawScene(const OverlaySceneView& scene, int width, int height) {
+        if (width <= 0 || height <= 0) return;
+
+        const SceneHeader& header = scene.GetHeader();
+        float scaleX = width / header.designWidth;
+        float scaleY = height / header.designHeight;
+        float scale = (std::min)(scaleX, scaleY);
+
+        // One brush for the whole scene, recolored per element
+        ID2D1SolidColorBrush* pBrush = nullptr;
+        if (FAILED(m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &pBrush))) return;
+
+        const SceneElement* elements = scene.GetElements();
+        uint32_t count = scene.GetElementCount();
+
+        m_batchStamps = true;
+        for (uint32_t i = 0; i < count; ++i) {
+            const SceneElement& e = elements[i];
+            if ((e.flags & kSceneFlagLowPriority) && !ShouldDrawLowPriority()) continue;
+
+            static_assert(sizeof(wchar_t) == sizeof(char16_t), "scene strings are UTF-16");
+            const wchar_t* text = e.type == (uint16_t)SceneElementType::Text ? reinterpret_cast<const wchar_t*>(scene.GetText(e)) : nullptr;
+
+            DrawElement((SceneElementType)e.type, e.color,
+                D2D1::Point2F(e.x0 * scaleX, e.y0 * scaleY), D2D1::Point2F(e.x1 * scaleX, e.y1 * scaleY),
+                e.size * scale, e.stroke, text, pBrush);
+        }
+        FlushStamps();
+        m_batchStamps = false;
+
+        pBrush->Release();
+    }
+
+    void DrawElement(SceneElementType type, uint32_t color, D2D1_POINT_2F p0, D2D1_POINT_2F p1, float size, float stroke,
+        const wchar_t* text, ID2D1SolidColorBrush* pBrush) {
+        // Consecutive markers are queued and drawn together; anything else has to wait for them
+        bool marker = type == SceneElementType::SolidCircle || type == SceneElementType::HollowCircle ||
+            type == SceneElementType::HollowDiamond || type == SceneElementType::CornerBox;
+        if (!marker) FlushStamps();
+
+        pBrush->SetColor(UnpackColor(color));
+
+        switch (type) {
+        case SceneElementType::Line:
+            SetShapeAntialias(FLT_MAX);
+            m_pRenderTarget->DrawLine(p0, p1, pBrush, stroke);
+            break;
+
+        case SceneElementType::SolidCircle:
+            DrawStamp(StampShape::SolidCircle, p0, size, size, 0.0f, UnpackColor(color));
+            break;
+
+        case SceneElementType::HollowCircle:
+            DrawStamp(StampShape::HollowCircle, p0, size, size, stroke, UnpackColor(color));
+            break;
+
+        case SceneElementType::HollowDiamond:
+            DrawStamp(StampShape::HollowDiamond, p0, size, size, stroke, UnpackColor(color));
+            break;
+
+        case SceneElementType::CornerBox:
+            DrawStamp(StampShape::CornerBox, D2D1::Point2F((p0.x + p1.x) / 2, (p0.y + p1.y) / 2),
+                (p1.x - p0.x) / 2, (p1.y - p0.y) / 2, stroke, UnpackColor(color));
+            break;
+
+        case SceneElementType::SolidRectangle:
+            SetShapeAntialias((std::max)(p1.x - p0.x, p1.y - p0.y));
+            m_pRenderTarget->FillRectangle(D2D1::RectF(p0.x, p0.y, p1.x, p1.y), pBrush);
+            break;
+
+        case SceneElementType::HollowRectangle:
+            SetShapeAntialias((std::max)(p1.x - p0.x, p1.y - p0.y));
+            m_pRenderTarget->DrawRectangle(D2D1::RectF(p0.x, p0.y, p1.x, p1.y), pBrush, stroke);
+            break;
+
+        case SceneElementType::Text:
+            if (text) DrawTextWithOutline(text, p0, size, UnpackColor(color));
+            break;
+
+        default:
+            break;
+        }
+    }
 
-        // Create D2D factory
-        hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &m_pD2DFactory);
-        if (FAILED(hr)) return false;
+    // A single-threaded factory has no thread affinity; it may be created on a worker
+    // as long as only one thread uses it at a time
+    static bool CreateD2DFactory(ID2D1Factory** ppFactory) {
+        return SUCCEEDED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, ppFactory));
+    }
 
-        // Create DirectWrite factory
-        hr = DWriteCreateFactory(
+    static bool CreateDWriteFactory(IDWriteFactory** ppFactory) {
+        return SUCCEEDED(DWriteCreateFactory(
             DWRITE_FACTORY_TYPE_SHARED,
             __uuidof(IDWriteFactory),
-            reinterpret_cast<IUnknown**>(&m_pDWriteFactory));
-        if (FAILED(hr)) return false;
+            reinterpret_cast<IUnknown**>(ppFactory)));
+    }
+
+    static bool CreateTextFormat(IDWriteFactory* pFactory, IDWriteTextFormat** ppTextFormat) {
+        if (!pFactory) return false;
 
-        // Create text format
-        hr = m_pDWriteFactory->CreateTextFormat(
+        return SUCCEEDED(pFactory->CreateTextFormat(
             L"TT Lakes",
             NULL,
             DWRITE_FONT_WEIGHT_NORMAL,
@@ -379,13 +1145,160 @@ private:
             DWRITE_FONT_STRETCH_NORMAL,
             14.0f,
             L"en-us",
-            &m_pTextFormatEnglish);
-        if (FAILED(hr)) return false;
+            ppTextFormat));
+    }
+
+    void DrawStampGeometry(StampShape shape, D2D1_POINT_2F center, float halfWidth, float halfHeight, float strokeWidth, D2D1::ColorF color) {
+        switch (shape) {
+        case StampShape::SolidCircle:
+            DrawSolidCircle(center, halfWidth, color);
+            break;
+
+        case StampShape::HollowCircle:
+            DrawHollowCircle(center, halfWidth, strokeWidth, color);
+            break;
+
+        case StampShape::HollowDiamond:
+            DrawHollowDiamond(center, halfWidth, strokeWidth, color);
+            break;
+
+        case StampShape::CornerBox:
+            DrawCornerBox(
+                { center.x - halfWidth, center.y - halfHeight },
+                { center.x + halfWidth, center.y - halfHeight },
+                { center.x - halfWidth, center.y + halfHeight },
+                { center.x + halfWidth, center.y + halfHeight },
+                strokeWidth, color);
+            break;
+        }
+    }
+
+    // Draws the queued stamps, tinting the white coverage with each stamp's color: one sprite
+    // batch when available, otherwise one opacity-mask fill per stamp
+    void FlushStamps() {
+        if (m_stampRun.empty()) return;
+
+        // Both calls require aliased mode; the stamps carry their own antialiasing
+        if (m_antialiasMode != D2D1_ANTIALIAS_MODE_ALIASED) m_pRenderTarget->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+
+        if (m_pSpriteBatch) {
+            const StampSprite& first = m_stampRun[0];
+            m_pSpriteBatch->Clear();
+            HRESULT hr = m_pSpriteBatch->AddSprites((UINT32)m_stampRun.size(), &first.destination, &first.source, &first.color,
+                nullptr, sizeof(StampSprite), sizeof(StampSprite), sizeof(StampSprite), 0);
+            if (SUCCEEDED(hr)) {
+                m_pSpriteContext->DrawSpriteBatch(m_pSpriteBatch, m_pStampBitmap, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, D2D1_SPRITE_OPTIONS_NONE);
+            }
+        }
+        else {
+            ID2D1SolidColorBrush* pBrush = nullptr;
+            if (SUCCEEDED(m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &pBrush))) {
+                for (const StampSprite& sprite : m_stampRun) {
+                    D2D1_RECT_F source = D2D1::RectF((float)sprite.source.left, (float)sprite.source.top,
+                        (float)sprite.source.right, (float)sprite.source.bottom);
+                    pBrush->SetColor(sprite.color);
+                    m_pRenderTarget->FillOpacityMask(m_pStampBitmap, pBrush, D2D1_OPACITY_MASK_CONTENT_GRAPHICS, &sprite.destination, &source);
+                }
+                pBrush->Release();
+            }
+        }
+
+        if (m_antialiasMode != D2D1_ANTIALIAS_MODE_ALIASED) m_pRenderTarget->SetAntialiasMode(m_antialiasMode);
+        m_stampRun.clear();
+    }
+
+    // Brings m_pStampBitmap up to date with the atlas
+    bool UploadStamps() {
+        return UploadAtlas(m_stampCache, &m_pStampBitmap, &m_stampGeneration);
+    }
+
+    bool UploadImages() {
+        return UploadAtlas(m_imageAtlas, &m_pImageBitmap, &m_imageGeneration);
+    }
+
+    // Mirrors a CPU atlas (StampCache or ImageAtlas) into a bitmap, uploading only what changed
+    template <typename Atlas>
+    bool UploadAtlas(Atlas& atlas, ID2D1Bitmap** ppBitmap, uint32_t* generation) {
+        const uint32_t* pixels = atlas.GetPixels();
+        UINT32 stride = (UINT32)atlas.GetStride();
+        if (!pixels) return false;
+
+        if (!*ppBitmap) {
+            D2D1_BITMAP_PROPERTIES props = D2D1::BitmapProperties(
+                D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
+            HRESULT hr = m_pRenderTarget->CreateBitmap(
+                D2D1::SizeU(atlas.GetWidth(), atlas.GetHeight()), pixels, stride, props, ppBitmap);
+            if (FAILED(hr)) return false;
+
+            *generation = atlas.GetGeneration();
+            atlas.ClearDirty();
+            return true;
+        }
+
+        if (*generation != atlas.GetGeneration()) {
+            // The atlas was repacked; draws already issued this frame still reference the old contents
+            m_pRenderTarget->Flush();
+            if (FAILED((*ppBitmap)->CopyFromMemory(nullptr, pixels, stride))) return false;
+
+            *generation = atlas.GetGeneration();
+            atlas.ClearDirty();
+            return true;
+        }
+
+        StampRect dirty;
+        if (atlas.GetDirtyRect(&dirty)) {
+            D2D1_RECT_U rect = D2D1::RectU(dirty.x, dirty.y, dirty.x + dirty.width, dirty.y + dirty.height);
+            const uint32_t* first = pixels + (size_t)dirty.y * atlas.GetWidth() + dirty.x;
+            if (FAILED((*ppBitmap)->CopyFromMemory(&rect, first, stride))) return false;
+
+            atlas.ClearDirty();
+        }
+
+        return true;
+    }
+
+    bool CreateDeviceD2D() {
+        if (!CreateD2DFactory(&m_pD2DFactory)) return false;
+        if (!CreateDWriteFactory(&m_pDWriteFactory)) return false;
+        if (!CreateTextFormat(m_pDWriteFactory, &m_pTextFormatEnglish)) return false;
 
         // The render target will be created in the UpdatePosition method
         return true;
     }
 
+    void ScheduleDeviceD2D(StartupPipeline& pipeline) {
+        StartupPipeline::TaskId d2d = pipeline.AddTask("D2D factory",
+            [this] { return CreateD2DFactory(&m_pending.pD2DFactory); });
+
+        StartupPipeline::TaskId dwrite = pipeline.AddTask("DWrite factory",
+            [this] { return CreateDWriteFactory(&m_pending.pDWriteFactory); });
+
+        StartupPipeline::TaskId font = pipeline.AddTask("text format",
+            [this] { return CreateTextFormat(m_pending.pDWriteFactory, &m_pending.pTextFormat); },
+            { dwrite });
+
+        StartupPipeline::TaskId device = pipeline.AddTask("overlay device", [] { return true; }, { d2d, font });
+        m_deviceTasks = { d2d, dwrite, font, device };
+    }
+
+    // Takes ownership of the background-created resources once they are all ready
+    bool AdoptDeviceD2D() {
+        if (!m_pPipeline || m_deviceFailed || !m_pPipeline->IsDone(m_deviceTasks.back())) return false;
+
+        if (!m_pPipeline->Succeeded(m_deviceTasks.back())) {
+            m_deviceFailed = true;
+            return false;
+        }
+
+        m_pD2DFactory = m_pending.pD2DFactory;
+        m_pDWriteFactory = m_pending.pDWriteFactory;
+        m_pTextFormatEnglish = m_pending.pTextFormat;
+        m_pending = {};
+
+        m_deviceReady = true;
+        return true;
+    }
+
     void CreateRenderTarget(int width, int height) {
         if (!m_pD2DFactory || width <= 0 || height <= 0) return;
 
@@ -404,12 +1317,26 @@ private:
             m_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0.2f, 0.2f, 0.2f, 0.08f), &m_pOutline2Brush);
 
             m_pRenderTarget->SetAntialiasMode(D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+            m_antialiasMode = D2D1_ANTIALIAS_MODE_PER_PRIMITIVE;
             m_pRenderTarget->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_DEFAULT);
+
+            // Stamp runs become one sprite batch where the render target supports it
+            if (SUCCEEDED(m_pRenderTarget->QueryInterface(__uuidof(ID2D1DeviceContext3), reinterpret_cast<void**>(&m_pSpriteContext))) &&
+                FAILED(m_pSpriteContext->CreateSpriteBatch(&m_pSpriteBatch))) {
+                SafeRelease(&m_pSpriteContext);
+            }
         }
 
     }
 
     void CleanupD2D() {
+        SafeRelease(&m_pStampBitmap);
+        SafeRelease(&m_pImageBitmap);
+        SafeRelease(&m_pSpriteBatch);
+        SafeRelease(&m_pSpriteContext);
+        SafeRelease(&m_pending.pTextFormat);
+        SafeRelease(&m_pending.pDWriteFactory);
+        SafeRelease(&m_pending.pD2DFactory);
         SafeRelease(&m_pOutline2Brush);
         SafeRelease(&m_pOutlineBrush);
         SafeRelease(&m_pTextFormatEnglish);
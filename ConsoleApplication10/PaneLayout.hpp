@@ -0,0 +1,255 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Same layout as a Win32 RECT, without depending on windows.h
+struct PaneRect {
+    int left, top, right, bottom;
+
+    int Width() const { return right - left; }
+    int Height() const { return bottom - top; }
+    bool IsEmpty() const { return right <= left || bottom <= top; }
+
+    bool operator==(const PaneRect&) const = default;
+};
+
+// One thumbnail pane: which part of the source it shows and where in the clone window.
+// Both are fractions of the respective client area, so panes follow resizes of either
+// window without being respecified.
+struct PaneSpec {
+    float sourceLeft = 0.0f;
+    float sourceTop = 0.0f;
+    float sourceRight = 1.0f;
+    float sourceBottom = 1.0f;
+
+    float destLeft = 0.0f;
+    float destTop = 0.0f;
+    float destRight = 1.0f;
+    float destBottom = 1.0f;
+
+    bool keepAspect = true; // Fit the source part into the destination area, centred
+    bool visible = true;
+    uint8_t opacity = 255;
+};
+
+struct PaneGeometry {
+    PaneRect source;      // Source window coordinates (client area offset included), as DWM takes it
+    PaneRect destination; // Clone window client coordinates
+    bool visible;
+    uint8_t opacity;
+
+    bool operator==(const PaneGeometry&) const = default;
+};
+
+// Maps points between source client coordinates and clone client coordinates for one pane
+struct PaneMapping {
+    PaneRect source;      // Source client coordinates
+    PaneRect destination; // Clone client coordinates
+    float scaleX;
+    float scaleY;
+
+    void ToDestination(float sourceX, float sourceY, float* destX, float* destY) const {
+        *destX = destination.left + (sourceX - source.left) * scaleX;
+        *destY = destination.top + (sourceY - source.top) * scaleY;
+    }
+
+    void ToSource(float destX, float destY, float* sourceX, float* sourceY) const {
+        *sourceX = source.left + (destX - destination.left) / scaleX;
+        *sourceY = source.top + (destY - destination.top) / scaleY;
+    }
+
+    bool ContainsDestination(float destX, float destY) const {
+        return destX >= destination.left && destX < destination.right &&
+            destY >= destination.top && destY < destination.bottom;
+    }
+};
+
+// A pane's overlay coordinate space. The overlay window covers pane 0, and draw code works
+// in its pixels; this maps such a point to where the same source point shows in another
+// pane, still relative to pane 0. clip is that pane's destination, relative to pane 0.
+struct PaneTransform {
+    float scaleX;
+    float scaleY;
+    float offsetX;
+    float offsetY;
+    PaneRect clip;
+
+    void Apply(float x, float y, float* outX, float* outY) const {
+        *outX = offsetX + x * scaleX;
+        *outY = offsetY + y * scaleY;
+    }
+};
+
+// Lays out thumbnail panes and works out which of them need their properties pushed.
+//
+// Update() recomputes every pane in one pass and hands only the panes whose geometry
+// differs from what was last committed to the caller's commit function, which applies it
+// to whatever thumbnail object backs the pane. A pane counts as committed only when
+// commit returns true, so a failed update is retried on the next pass.
+class PaneLayout {
+public:
+    size_t AddPane(const PaneSpec& spec) {
+        Pane pane;
+        pane.spec = spec;
+        pane.current = EmptyGeometry();
+        pane.committed = EmptyGeometry();
+        pane.hasCommitted = false;
+        m_panes.push_back(pane);
+        return m_panes.size() - 1;
+    }
+
+    bool SetPane(size_t index, const PaneSpec& spec) {
+        if (index >= m_panes.size()) return false;
+
+        m_panes[index].spec = spec;
+        return true;
+    }
+
+    // Forces the pane to be committed on the next Update(), e.g. after its thumbnail was recreated
+    void Invalidate(size_t index) {
+        if (index < m_panes.size()) m_panes[index].hasCommitted = false;
+    }
+
+    size_t GetPaneCount() const { return m_panes.size(); }
+
+    const PaneSpec& GetPane(size_t index) const { return m_panes[index].spec; }
+
+    // Geometry from the latest Update(), committed or not
+    const PaneGeometry& GetGeometry(size_t index) const { return m_panes[index].current; }
+
+    // sourceClient is the source client area in source window coordinates. commit is called
+    // as commit(index, geometry) -> bool. Returns the number of panes committed.
+    template <typename Commit>
+    size_t Update(const PaneRect& sourceClient, int clientWidth, int clientHeight, Commit commit) {
+        m_sourceClient = sourceClient;
+
+        size_t committed = 0;
+        for (size_t index = 0; index < m_panes.size(); ++index) {
+            Pane& pane = m_panes[index];
+            pane.current = Compute(pane.spec, sourceClient, clientWidth, clientHeight);
+
+            if (pane.hasCommitted && pane.current == pane.committed) continue;
+
+            if (commit(index, pane.current)) {
+                pane.committed = pane.current;
+                pane.hasCommitted = true;
+                committed++;
+            }
+        }
+
+        return committed;
+    }
+
+    // False while the pane is hidden or empty
+    bool GetMapping(size_t index, PaneMapping* mapping) const {
+        if (index >= m_panes.size() || !mapping) return false;
+
+        const PaneGeometry& geometry = m_panes[index].current;
+        if (!geometry.visible) return false;
+
+        mapping->source = {
+            geometry.source.left - m_sourceClient.left,
+            geometry.source.top - m_sourceClient.top,
+            geometry.source.right - m_sourceClient.left,
+            geometry.source.bottom - m_sourceClient.top };
+        mapping->destination = geometry.destination;
+        mapping->scaleX = (float)geometry.destination.Width() / geometry.source.Width();
+        mapping->scaleY = (float)geometry.destination.Height() / geometry.source.Height();
+        return true;
+    }
+
+    // False while pane 0 or the pane is hidden or empty. Pane 0 maps to itself.
+    bool GetOverlayTransform(size_t index, PaneTransform* transform) const {
+        PaneMapping main, pane;
+        if (!transform || !GetMapping(0, &main) || !GetMapping(index, &pane)) return false;
+
+        // Overlay point -> source client (through pane 0) -> clone client (through the pane)
+        transform->scaleX = pane.scaleX / main.scaleX;
+        transform->scaleY = pane.scaleY / main.scaleY;
+        transform->offsetX = (pane.destination.left - main.destination.left) + (main.source.left - pane.source.left) * pane.scaleX;
+        transform->offsetY = (pane.destination.top - main.destination.top) + (main.source.top - pane.source.top) * pane.scaleY;
+        transform->clip = {
+            pane.destination.left - main.destination.left,
+            pane.destination.top - main.destination.top,
+            pane.destination.right - main.destination.left,
+            pane.destination.bottom - main.destination.top };
+        return true;
+    }
+
+private:
+    struct Pane {
+        PaneSpec spec;
+        PaneGeometry current;
+        PaneGeometry committed;
+        bool hasCommitted;
+    };
+
+    std::vector<Pane> m_panes;
+    PaneRect m_sourceClient = { 0, 0, 0, 0 };
+
+    static PaneGeometry EmptyGeometry() {
+        return { { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, false, 0 };
+    }
+
+    static int Lerp(int from, int length, float fraction) {
+        return from + (int)std::lround(length * fraction);
+    }
+
+    static PaneGeometry Compute(const PaneSpec& spec, const PaneRect& sourceClient, int clientWidth, int clientHeight) {
+        PaneGeometry geometry = EmptyGeometry();
+
+        geometry.source = {
+            Lerp(sourceClient.left, sourceClient.Width(), spec.sourceLeft),
+            Lerp(sourceClient.top, sourceClient.Height(), spec.sourceTop),
+            Lerp(sourceClient.left, sourceClient.Width(), spec.sourceRight),
+            Lerp(sourceClient.top, sourceClient.Height(), spec.sourceBottom) };
+
+        PaneRect area = {
+            Lerp(0, clientWidth, spec.destLeft),
+            Lerp(0, clientHeight, spec.destTop),
+            Lerp(0, clientWidth, spec.destRight),
+            Lerp(0, clientHeight, spec.destBottom) };
+
+        if (geometry.source.IsEmpty() || area.IsEmpty()) {
+            geometry.source = { 0, 0, 0, 0 };
+            return geometry;
+        }
+
+        geometry.destination = area;
+        if (spec.keepAspect) {
+            int srcWidth = geometry.source.Width();
+            int srcHeight = geometry.source.Height();
+            int areaWidth = area.Width();
+            int areaHeight = area.Height();
+
+            float srcAspectRatio = (float)srcWidth / srcHeight;
+            float areaAspectRatio = (float)areaWidth / areaHeight;
+
+            int dstWidth, dstHeight;
+            if (srcAspectRatio > areaAspectRatio) {
+                dstWidth = areaWidth;
+                dstHeight = (int)(dstWidth / srcAspectRatio);
+            }
+            else {
+                dstHeight = areaHeight;
+                dstWidth = (int)(dstHeight * srcAspectRatio);
+            }
+
+            int x = area.left + (areaWidth - dstWidth) / 2;
+            int y = area.top + (areaHeight - dstHeight) / 2;
+            geometry.destination = { x, y, x + dstWidth, y + dstHeight };
+
+            if (geometry.destination.IsEmpty()) {
+                geometry.source = { 0, 0, 0, 0 };
+                geometry.destination = { 0, 0, 0, 0 };
+                return geometry;
+            }
+        }
+
+        geometry.visible = spec.visible;
+        geometry.opacity = spec.opacity;
+        return geometry;
+    }
+};
@@ -0,0 +1,142 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Quality tiers, cumulative: every tier keeps the reductions of the tiers before it
+enum class QualityTier : int {
+    Full = 0,
+    NoOuterOutline,     // Text is drawn with the inner outline ring only
+    AliasedSmallShapes, // Small shapes are drawn without antialiasing
+    ReducedRate,        // The overlay refresh rate is capped (saves time per second, not per frame)
+    EssentialOnly,      // Low-priority layers are skipped
+};
+
+struct QualityGovernorConfig {
+    int64_t budgetUs = 8000;            // Frame time the overlay should stay under
+    size_t windowFrames = 30;           // Frames per evaluation
+    double downgradePercentile = 0.9;   // Statistic compared against the budget
+    double downgradeRatio = 1.0;        // Drop a tier when the statistic exceeds budget * ratio
+    double upgradeRatio = 0.6;          // Calm when the statistic is under budget * ratio
+    size_t upgradeWindows = 4;          // Calm windows in a row needed to raise a tier
+    size_t maxUpgradeWindows = 64;      // Cap for the backoff after a bounce
+    int64_t reducedFrameIntervalUs = 33333; // Refresh cap at ReducedRate and EssentialOnly
+};
+
+// Steps through the quality tiers from recent frame times.
+//
+// Frame times are collected in windows and each full window is evaluated once. A window
+// whose high percentile is over budget drops one tier immediately. Raising a tier needs
+// several windows in a row well under budget (the gap between downgradeRatio and
+// upgradeRatio is the hysteresis band). If a raised tier is over budget again in its
+// first window, the number of calm windows required next time doubles (and halves again
+// once a raised tier holds), so a load that sits right at a tier boundary settles
+// instead of oscillating.
+//
+// ReducedRate is a CPU/power measure: capping the refresh rate leaves the cost of each
+// frame, which is what the governor measures, unchanged. An over-budget window therefore
+// never stops at ReducedRate; it goes on to EssentialOnly, which keeps the cap. On the
+// way back up ReducedRate is a step of its own: low-priority layers return while the cap
+// still holds, and the cap is lifted only after that tier has been calm.
+class QualityGovernor {
+public:
+    explicit QualityGovernor(const QualityGovernorConfig& config = QualityGovernorConfig())
+        : m_config(config),
+        m_tier(QualityTier::Full),
+        m_calmWindows(0),
+        m_requiredCalmWindows(config.upgradeWindows),
+        m_windowsSinceUpgrade(0),
+        m_upgraded(false) {
+        m_window.reserve(m_config.windowFrames);
+    }
+
+    void SetConfig(const QualityGovernorConfig& config) {
+        m_config = config;
+        m_requiredCalmWindows = config.upgradeWindows;
+        m_calmWindows = 0;
+        m_window.clear();
+    }
+
+    const QualityGovernorConfig& GetConfig() const { return m_config; }
+
+    // Returns true when the tier changed
+    bool AddFrame(int64_t frameTimeUs) {
+        m_window.push_back(frameTimeUs);
+        if (m_window.size() < (std::max)(m_config.windowFrames, (size_t)1)) return false;
+
+        int64_t statistic = WindowPercentile(m_config.downgradePercentile);
+        m_window.clear();
+        m_windowsSinceUpgrade++;
+
+        if (statistic > m_config.budgetUs * m_config.downgradeRatio) {
+            m_calmWindows = 0;
+
+            // Over budget right after an upgrade: back off before trying again
+            if (m_upgraded && m_windowsSinceUpgrade <= 1) {
+                m_requiredCalmWindows = (std::min)(m_requiredCalmWindows * 2, m_config.maxUpgradeWindows);
+            }
+            m_upgraded = false;
+
+            if (m_tier == QualityTier::EssentialOnly) return false;
+            m_tier = (QualityTier)((int)m_tier + 1);
+            if (m_tier == QualityTier::ReducedRate) m_tier = QualityTier::EssentialOnly;
+            return true;
+        }
+
+        // A raised tier that has held for a while earns back the shorter wait
+        if (m_upgraded && m_windowsSinceUpgrade >= m_requiredCalmWindows) {
+            m_requiredCalmWindows = (std::max)(m_requiredCalmWindows / 2, m_config.upgradeWindows);
+            m_upgraded = false;
+        }
+
+        if (statistic < m_config.budgetUs * m_config.upgradeRatio) {
+            if (++m_calmWindows < m_requiredCalmWindows || m_tier == QualityTier::Full) return false;
+
+            m_calmWindows = 0;
+            m_upgraded = true;
+            m_windowsSinceUpgrade = 0;
+            m_tier = (QualityTier)((int)m_tier - 1);
+            return true;
+        }
+
+        // Inside the hysteresis band: hold
+        m_calmWindows = 0;
+        return false;
+    }
+
+    QualityTier GetTier() const { return m_tier; }
+
+    bool IsAtLeast(QualityTier tier) const { return (int)m_tier >= (int)tier; }
+
+    // Minimum time between overlay frames, 0 when uncapped
+    int64_t GetMinFrameIntervalUs() const {
+        return IsAtLeast(QualityTier::ReducedRate) ? m_config.reducedFrameIntervalUs : 0;
+    }
+
+    size_t GetRequiredCalmWindows() const { return m_requiredCalmWindows; }
+
+    void Reset() {
+        m_tier = QualityTier::Full;
+        m_calmWindows = 0;
+        m_requiredCalmWindows = m_config.upgradeWindows;
+        m_windowsSinceUpgrade = 0;
+        m_upgraded = false;
+        m_window.clear();
+    }
+
+private:
+    QualityGovernorConfig m_config;
+    QualityTier m_tier;
+    size_t m_calmWindows;
+    size_t m_requiredCalmWindows;
+    size_t m_windowsSinceUpgrade;
+    bool m_upgraded;
+    std::vector<int64_t> m_window;
+
+    int64_t WindowPercentile(double p) {
+        size_t index = (size_t)(p * (m_window.size() - 1) + 0.5);
+        std::nth_element(m_window.begin(), m_window.begin() + index, m_window.end());
+        return m_window[index];
+    }
+};
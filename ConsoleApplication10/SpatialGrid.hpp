@@ -0,0 +1,398 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPATIALGRID_SSE2 1
+#endif
+
+struct SpatialRect {
+    float left, top, right, bottom;
+};
+
+// Uniform-grid spatial hash over axis-aligned rectangles.
+//
+// Every element is listed in the hash bucket of each grid cell its rectangle touches;
+// elements spanning more than kMaxCellsPerElement cells go to a separate list that every
+// query scans instead. Buckets are a fixed power-of-two table, so distinct cells may share
+// a bucket and all queries test the actual rectangles. Moving an element whose cell range
+// is unchanged only rewrites its rectangle, and RemoveStale() does nothing when every
+// element was updated, which keeps per-frame updates of mostly-static content cheap.
+//
+// Elements are addressed by the handle Insert() returns; handles of removed elements are
+// reused. Queries are not thread-safe (they mark visited elements).
+class SpatialGrid {
+public:
+    using Handle = uint32_t;
+    static constexpr Handle kInvalidHandle = 0xFFFFFFFFu;
+
+    explicit SpatialGrid(float cellSize = 64.0f, size_t bucketCount = 4096)
+        : m_cellSize(cellSize > 0.0f ? cellSize : 64.0f),
+        m_inverseCellSize(1.0f / m_cellSize),
+        m_freeList(kInvalidHandle),
+        m_count(0),
+        m_current(0),
+        m_frame(0),
+        m_stamp(0),
+        m_order(0) {
+        size_t buckets = 1;
+        while (buckets < bucketCount) buckets <<= 1;
+        m_buckets.resize(buckets);
+        m_bucketMask = (uint32_t)(buckets - 1);
+    }
+
+    Handle Insert(const SpatialRect& rect, uint32_t userId) {
+        Handle handle;
+        if (m_freeList != kInvalidHandle) {
+            handle = m_freeList;
+            m_freeList = m_elements[handle].nextFree;
+        }
+        else {
+            handle = (Handle)m_elements.size();
+            m_elements.push_back(Element());
+        }
+
+        Element& element = m_elements[handle];
+        element.rect = rect;
+        element.userId = userId;
+        element.order = ++m_order;
+        element.frame = m_frame;
+        element.stamp = m_stamp;
+        element.live = true;
+        m_current++;
+        element.nextFree = kInvalidHandle;
+        ComputeCells(rect, element);
+        Link(handle);
+
+        m_count++;
+        if (m_count > m_buckets.size()) Rehash(m_buckets.size() * 2);
+        return handle;
+    }
+
+    // Also marks the element as current (see RemoveStale) and raises it to the top
+    void Move(Handle handle, const SpatialRect& rect) {
+        if (!IsLive(handle)) return;
+
+        Element& element = m_elements[handle];
+        element.order = ++m_order;
+        if (element.frame != m_frame) {
+            element.frame = m_frame;
+            m_current++;
+        }
+
+        if (rect.left == element.rect.left && rect.top == element.rect.top &&
+            rect.right == element.rect.right && rect.bottom == element.rect.bottom) return;
+
+        element.rect = rect;
+
+        int32_t cellX0, cellY0, cellX1, cellY1;
+        CellRange(rect, &cellX0, &cellY0, &cellX1, &cellY1);
+        if (cellX0 == element.cellX0 && cellY0 == element.cellY0 &&
+            cellX1 == element.cellX1 && cellY1 == element.cellY1) return;
+
+        if (element.oversized) {
+            Unlink(handle);
+            ComputeCells(rect, element);
+            Link(handle);
+            return;
+        }
+
+        // Only the buckets the element leaves or enters change; a small move usually keeps most
+        uint32_t oldBuckets[kMaxCellsPerElement];
+        size_t oldCount = CollectBuckets(element, oldBuckets);
+        ComputeCells(rect, element);
+        if (element.oversized) {
+            for (size_t i = 0; i < oldCount; ++i) EraseFrom(m_buckets[oldBuckets[i]], handle);
+            m_oversized.push_back(handle);
+            return;
+        }
+
+        uint32_t newBuckets[kMaxCellsPerElement];
+        size_t newCount = CollectBuckets(element, newBuckets);
+        for (size_t i = 0; i < oldCount; ++i) {
+            if (std::find(newBuckets, newBuckets + newCount, oldBuckets[i]) == newBuckets + newCount) EraseFrom(m_buckets[oldBuckets[i]], handle);
+        }
+        for (size_t i = 0; i < newCount; ++i) {
+            if (std::find(oldBuckets, oldBuckets + oldCount, newBuckets[i]) == oldBuckets + oldCount) m_buckets[newBuckets[i]].push_back(handle);
+        }
+    }
+
+    void Remove(Handle handle) {
+        if (!IsLive(handle)) return;
+
+        Unlink(handle);
+        Element& element = m_elements[handle];
+        if (element.frame == m_frame) m_current--;
+        element.live = false;
+        element.nextFree = m_freeList;
+        m_freeList = handle;
+        m_count--;
+    }
+
+    void Clear() {
+        for (std::vector<Handle>& bucket : m_buckets) bucket.clear();
+        m_oversized.clear();
+        m_elements.clear();
+        m_freeList = kInvalidHandle;
+        m_count = 0;
+        m_current = 0;
+    }
+
+    // Starts a new update pass; elements not inserted or moved since are stale
+    void BeginFrame() {
+        m_frame++;
+        m_current = 0;
+    }
+
+    // Removes the elements that were not inserted or moved since the last BeginFrame() and
+    // returns how many there were. Free when nothing is stale.
+    size_t RemoveStale() {
+        size_t stale = m_count - m_current;
+        size_t removed = 0;
+        for (Handle handle = 0; removed < stale && handle < (Handle)m_elements.size(); ++handle) {
+            if (m_elements[handle].live && m_elements[handle].frame != m_frame) {
+                Remove(handle);
+                removed++;
+            }
+        }
+        return removed;
+    }
+
+    bool IsLive(Handle handle) const {
+        return handle < m_elements.size() && m_elements[handle].live;
+    }
+
+    size_t GetCount() const { return m_count; }
+
+    const SpatialRect& GetRect(Handle handle) const { return m_elements[handle].rect; }
+    uint32_t GetUserId(Handle handle) const { return m_elements[handle].userId; }
+
+    // Calls fn(handle) once for every element whose rectangle overlaps rect. Touching
+    // edges do not count as overlap. Returning false from fn stops the query.
+    template <typename Fn>
+    void QueryRect(const SpatialRect& rect, Fn fn) {
+        if (!(rect.left < rect.right && rect.top < rect.bottom)) return;
+
+        uint32_t stamp = NextStamp();
+
+        for (Handle handle : m_oversized) {
+            Element& element = m_elements[handle];
+            if (Overlaps(element.rect, rect) && !fn(handle)) return;
+        }
+
+        int32_t cellX0, cellY0, cellX1, cellY1;
+        CellRange(rect, &cellX0, &cellY0, &cellX1, &cellY1);
+
+        // A query wider than the table visits every bucket once instead
+        bool scanAll = (uint64_t)(cellX1 - cellX0 + 1) * (uint64_t)(cellY1 - cellY0 + 1) > m_buckets.size();
+        if (scanAll) {
+            for (const std::vector<Handle>& bucket : m_buckets) {
+                if (!VisitBucket(bucket, rect, stamp, fn)) return;
+            }
+            return;
+        }
+
+        for (int32_t cellY = cellY0; cellY <= cellY1; ++cellY) {
+            for (int32_t cellX = cellX0; cellX <= cellX1; ++cellX) {
+                if (!VisitBucket(m_buckets[BucketOf(cellX, cellY)], rect, stamp, fn)) return;
+            }
+        }
+    }
+
+    bool AnyOverlap(const SpatialRect& rect) {
+        bool found = false;
+        QueryRect(rect, [&](Handle) { found = true; return false; });
+        return found;
+    }
+
+    // Calls fn(handle) for every element containing the point (edges inclusive)
+    template <typename Fn>
+    void QueryPoint(float x, float y, Fn fn) const {
+        for (Handle handle : m_oversized) {
+            if (Contains(m_elements[handle].rect, x, y) && !fn(handle)) return;
+        }
+
+        // A point lies in exactly one cell, so every element is seen at most once
+        for (Handle handle : m_buckets[BucketOf(CellOf(x), CellOf(y))]) {
+            if (Contains(m_elements[handle].rect, x, y) && !fn(handle)) return;
+        }
+    }
+
+    // The most recently inserted or moved element containing the point
+    Handle HitTest(float x, float y) const {
+        Handle top = kInvalidHandle;
+        uint64_t topOrder = 0;
+
+        QueryPoint(x, y, [&](Handle handle) {
+            if (m_elements[handle].order > topOrder) {
+                topOrder = m_elements[handle].order;
+                top = handle;
+            }
+            return true;
+        });
+
+        return top;
+    }
+
+private:
+    static constexpr int32_t kMaxCellsPerElement = 16;
+
+    struct Element {
+        SpatialRect rect;
+        uint32_t userId;
+        int32_t cellX0, cellY0, cellX1, cellY1;
+        uint64_t order;
+        uint32_t frame;
+        uint32_t stamp;
+        Handle nextFree;
+        bool oversized;
+        bool live;
+    };
+
+    float m_cellSize;
+    float m_inverseCellSize;
+    std::vector<Element> m_elements;
+    std::vector<std::vector<Handle>> m_buckets;
+    std::vector<Handle> m_oversized;
+    uint32_t m_bucketMask;
+    Handle m_freeList;
+    size_t m_count;
+    size_t m_current; // Live elements inserted or moved since BeginFrame()
+    uint32_t m_frame;
+    uint32_t m_stamp;
+    uint64_t m_order;
+
+    static bool Overlaps(const SpatialRect& a, const SpatialRect& b) {
+        return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+    }
+
+    static bool Contains(const SpatialRect& rect, float x, float y) {
+        return x >= rect.left && x <= rect.right && y >= rect.top && y <= rect.bottom;
+    }
+
+    // Truncation plus a fix-up for negatives; std::floor is a library call without SSE4.1
+    int32_t CellOf(float coordinate) const {
+        float cell = (std::min)(1073741824.0f, (std::max)(-1073741824.0f, coordinate * m_inverseCellSize)); // NaN goes low
+        int32_t truncated = (int32_t)cell;
+        return truncated - (cell < (float)truncated ? 1 : 0);
+    }
+
+    // Same result as CellOf on each edge; this runs for every Move()
+    void CellRange(const SpatialRect& rect, int32_t* cellX0, int32_t* cellY0, int32_t* cellX1, int32_t* cellY1) const {
+#ifdef SPATIALGRID_SSE2
+        __m128 cell = _mm_mul_ps(_mm_loadu_ps(&rect.left), _mm_set1_ps(m_inverseCellSize));
+        cell = _mm_min_ps(_mm_max_ps(cell, _mm_set1_ps(-1073741824.0f)), _mm_set1_ps(1073741824.0f)); // NaN goes low
+        __m128i truncated = _mm_cvttps_epi32(cell);
+        __m128i floored = _mm_add_epi32(truncated, _mm_castps_si128(_mm_cmplt_ps(cell, _mm_cvtepi32_ps(truncated))));
+
+        alignas(16) int32_t cells[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(cells), floored);
+        *cellX0 = cells[0];
+        *cellY0 = cells[1];
+        *cellX1 = (std::max)(cells[2], cells[0]);
+        *cellY1 = (std::max)(cells[3], cells[1]);
+#else
+        *cellX0 = CellOf(rect.left);
+        *cellY0 = CellOf(rect.top);
+        *cellX1 = (std::max)(CellOf(rect.right), *cellX0);
+        *cellY1 = (std::max)(CellOf(rect.bottom), *cellY0);
+#endif
+    }
+
+    void ComputeCells(const SpatialRect& rect, Element& element) const {
+        CellRange(rect, &element.cellX0, &element.cellY0, &element.cellX1, &element.cellY1);
+        element.oversized = (int64_t)(element.cellX1 - element.cellX0 + 1) * (element.cellY1 - element.cellY0 + 1) > kMaxCellsPerElement;
+    }
+
+    uint32_t BucketOf(int32_t cellX, int32_t cellY) const {
+        return (((uint32_t)cellX * 73856093u) ^ ((uint32_t)cellY * 19349663u)) & m_bucketMask;
+    }
+
+    uint32_t NextStamp() {
+        // On wrap-around old stamps could match again, so reset them all
+        if (++m_stamp == 0) {
+            for (Element& element : m_elements) element.stamp = 0;
+            m_stamp = 1;
+        }
+        return m_stamp;
+    }
+
+    template <typename Fn>
+    bool VisitBucket(const std::vector<Handle>& bucket, const SpatialRect& rect, uint32_t stamp, Fn& fn) {
+        for (Handle handle : bucket) {
+            Element& element = m_elements[handle];
+            if (element.stamp == stamp) continue;
+
+            element.stamp = stamp;
+            if (Overlaps(element.rect, rect) && !fn(handle)) return false;
+        }
+        return true;
+    }
+
+    // Distinct buckets of a non-oversized element's cells, at most kMaxCellsPerElement
+    size_t CollectBuckets(const Element& element, uint32_t* buckets) const {
+        size_t count = 0;
+        for (int32_t cellY = element.cellY0; cellY <= element.cellY1; ++cellY) {
+            for (int32_t cellX = element.cellX0; cellX <= element.cellX1; ++cellX) {
+                uint32_t bucket = BucketOf(cellX, cellY);
+                if (std::find(buckets, buckets + count, bucket) == buckets + count) buckets[count++] = bucket;
+            }
+        }
+        return count;
+    }
+
+    // Cells of one element can hash to the same bucket; the element is listed there once.
+    // Nothing else is added while linking, so a repeat is always at the back.
+    void Link(Handle handle) {
+        const Element& element = m_elements[handle];
+        if (element.oversized) {
+            m_oversized.push_back(handle);
+            return;
+        }
+
+        for (int32_t cellY = element.cellY0; cellY <= element.cellY1; ++cellY) {
+            for (int32_t cellX = element.cellX0; cellX <= element.cellX1; ++cellX) {
+                std::vector<Handle>& bucket = m_buckets[BucketOf(cellX, cellY)];
+                if (bucket.empty() || bucket.back() != handle) bucket.push_back(handle);
+            }
+        }
+    }
+
+    void Unlink(Handle handle) {
+        const Element& element = m_elements[handle];
+        if (element.oversized) {
+            EraseFrom(m_oversized, handle);
+            return;
+        }
+
+        for (int32_t cellY = element.cellY0; cellY <= element.cellY1; ++cellY) {
+            for (int32_t cellX = element.cellX0; cellX <= element.cellX1; ++cellX) {
+                EraseFrom(m_buckets[BucketOf(cellX, cellY)], handle);
+            }
+        }
+    }
+
+    static void EraseFrom(std::vector<Handle>& list, Handle handle) {
+        auto it = std::find(list.begin(), list.end(), handle);
+        if (it == list.end()) return;
+
+        *it = list.back();
+        list.pop_back();
+    }
+
+    void Rehash(size_t bucketCount) {
+        for (std::vector<Handle>& bucket : m_buckets) bucket.clear();
+        m_oversized.clear();
+
+        m_buckets.resize(bucketCount);
+        m_bucketMask = (uint32_t)(bucketCount - 1);
+
+        for (Handle handle = 0; handle < (Handle)m_elements.size(); ++handle) {
+            if (m_elements[handle].live) Link(handle);
+        }
+    }
+};
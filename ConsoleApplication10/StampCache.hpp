@@ -0,0 +1,398 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Stamp cache
+//
+// Markers that are drawn many times per frame (filled and hollow circles, diamonds,
+// corner boxes) are rasterized once per (shape, size, stroke) into a shared atlas and
+// then drawn as bitmap blits. Sizes and strokes are quantized to 1/4 px so nearby sizes
+// share a stamp. Stamps hold white coverage and are tinted when drawn, so animated
+// colors reuse the same stamp. Atlas pixels are premultiplied BGRA (0xAARRGGBB in
+// memory order B, G, R, A), the layout D2D uses for DXGI_FORMAT_B8G8R8A8_UNORM.
+
+enum class StampShape : uint8_t {
+    SolidCircle,
+    HollowCircle,
+    HollowDiamond,
+    CornerBox,
+};
+
+struct StampKey {
+    uint8_t shape;
+    uint16_t halfWidth;  // Quarter pixels
+    uint16_t halfHeight; // Quarter pixels
+    uint16_t stroke;     // Quarter pixels
+
+    bool operator==(const StampKey& other) const {
+        return shape == other.shape && halfWidth == other.halfWidth && halfHeight == other.halfHeight &&
+            stroke == other.stroke;
+    }
+};
+
+struct StampKeyHash {
+    size_t operator()(const StampKey& key) const {
+        uint64_t h = ((uint64_t)key.shape << 48) ^ ((uint64_t)key.halfWidth << 32) ^
+            ((uint64_t)key.halfHeight << 16) ^ key.stroke;
+        h *= 0x9E3779B97F4A7C15ull;
+        return (size_t)(h ^ (h >> 29));
+    }
+};
+
+struct StampRect {
+    int x, y, width, height;
+};
+
+struct Stamp {
+    StampRect rect;  // Location in the atlas
+    float originX;   // Position of the shape's center inside rect
+    float originY;
+};
+
+// Shelf packer: stamps are placed left to right on horizontal shelves, a new shelf is
+// opened below the last one when no existing shelf has room
+class AtlasAllocator {
+public:
+    AtlasAllocator() : m_width(0), m_height(0), m_nextShelfY(0) {}
+
+    void Reset(int width, int height) {
+        m_width = width;
+        m_height = height;
+        m_nextShelfY = 0;
+        m_shelves.clear();
+    }
+
+    bool Allocate(int width, int height, StampRect* rect) {
+        if (width <= 0 || height <= 0 || width > m_width || height > m_height) return false;
+
+        // Best fit: the lowest shelf that is tall enough and has room
+        Shelf* best = nullptr;
+        for (Shelf& shelf : m_shelves) {
+            if (shelf.height >= height && m_width - shelf.used >= width &&
+                (!best || shelf.height < best->height)) {
+                best = &shelf;
+            }
+        }
+
+        // Avoid wasting tall shelves on small stamps when a tighter shelf can be opened
+        if (!best || (best->height > height * 2 && m_height - m_nextShelfY >= height)) {
+            if (m_height - m_nextShelfY < height) {
+                if (!best) return false;
+            }
+            else {
+                m_shelves.push_back({ m_nextShelfY, height, 0 });
+                m_nextShelfY += height;
+                best = &m_shelves.back();
+            }
+        }
+
+        *rect = { best->used, best->y, width, height };
+        best->used += width;
+        return true;
+    }
+
+private:
+    struct Shelf {
+        int y;
+        int height;
+        int used;
+    };
+
+    int m_width;
+    int m_height;
+    int m_nextShelfY;
+    std::vector<Shelf> m_shelves;
+};
+
+class StampCache {
+public:
+    // Larger shapes are cheaper to draw as geometry than to keep in the atlas
+    static constexpr int kMaxStampSize = 128;
+
+    StampCache(int atlasWidth = 1024, int atlasHeight = 1024)
+        : m_width(atlasWidth),
+        m_height(atlasHeight),
+        m_generation(0),
+        m_dirty(false) {
+        m_dirtyRect = { 0, 0, 0, 0 };
+    }
+
+    static StampKey MakeKey(StampShape shape, float halfWidth, float halfHeight, float stroke) {
+        StampKey key;
+        key.shape = (uint8_t)shape;
+        key.halfWidth = Quantize(halfWidth);
+        key.halfHeight = Quantize(halfHeight);
+        key.stroke = shape == StampShape::SolidCircle ? 0 : Quantize(stroke);
+        return key;
+    }
+
+    // Returns the cached stamp without rasterizing, nullptr on a miss
+    const Stamp* Peek(const StampKey& key) const {
+        auto it = m_stamps.find(key);
+        return it != m_stamps.end() ? &it->second : nullptr;
+    }
+
+    // Returns the cached stamp, rasterizing it on a miss. Returns nullptr if the shape is
+    // too large to be stamped. A miss on a full atlas clears it and bumps the generation,
+    // which invalidates every Stamp pointer returned before.
+    const Stamp* Find(const StampKey& key) {
+        auto it = m_stamps.find(key);
+        if (it != m_stamps.end()) return &it->second;
+
+        float halfWidth = key.halfWidth / 4.0f;
+        float halfHeight = key.halfHeight / 4.0f;
+        float halfStroke = key.stroke / 8.0f;
+
+        // A diamond's stroke reaches further past the tips than its width, as it is measured
+        // across the slanted edge
+        float reach = (StampShape)key.shape == StampShape::HollowDiamond ? (halfStroke + 0.5f) * 1.41421356f - 0.5f : halfStroke;
+
+        // One pixel of padding on each side keeps bilinear sampling inside the stamp
+        int width = (int)std::ceil(2.0f * (halfWidth + reach)) + 2;
+        int height = (int)std::ceil(2.0f * (halfHeight + reach)) + 2;
+        if (width > kMaxStampSize || height > kMaxStampSize) return nullptr;
+
+        if (m_pixels.empty()) {
+            m_pixels.assign((size_t)m_width * m_height, 0);
+            m_allocator.Reset(m_width, m_height);
+        }
+
+        StampRect rect;
+        if (!m_allocator.Allocate(width, height, &rect)) {
+            Clear();
+            if (!m_allocator.Allocate(width, height, &rect)) return nullptr;
+        }
+
+        Stamp stamp;
+        stamp.rect = rect;
+        stamp.originX = width * 0.5f;
+        stamp.originY = height * 0.5f;
+
+        Rasterize(key, stamp);
+        MarkDirty(rect);
+
+        return &m_stamps.emplace(key, stamp).first->second;
+    }
+
+    const uint32_t* GetPixels() const { return m_pixels.empty() ? nullptr : m_pixels.data(); }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    size_t GetStride() const { return (size_t)m_width * sizeof(uint32_t); }
+    size_t GetStampCount() const { return m_stamps.size(); }
+
+    // Incremented every time the atlas is cleared
+    uint32_t GetGeneration() const { return m_generation; }
+
+    // Region rasterized since the last ClearDirty(), for partial texture uploads
+    bool GetDirtyRect(StampRect* rect) const {
+        if (!m_dirty) return false;
+        *rect = m_dirtyRect;
+        return true;
+    }
+
+    void ClearDirty() { m_dirty = false; }
+
+    void Clear() {
+        m_stamps.clear();
+        std::fill(m_pixels.begin(), m_pixels.end(), 0u);
+        m_allocator.Reset(m_width, m_height);
+        m_generation++;
+        m_dirty = false;
+    }
+
+private:
+    int m_width;
+    int m_height;
+    uint32_t m_generation;
+    bool m_dirty;
+    StampRect m_dirtyRect;
+    std::vector<uint32_t> m_pixels;
+    AtlasAllocator m_allocator;
+    std::unordered_map<StampKey, Stamp, StampKeyHash> m_stamps;
+
+    static uint16_t Quantize(float value) {
+        float q = std::floor(value * 4.0f + 0.5f);
+        return (uint16_t)(q < 0.0f ? 0.0f : (q > 65535.0f ? 65535.0f : q));
+    }
+
+    static float Clamp01(float value) {
+        return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    }
+
+    // Exact coverage of the pixel [px, px+1) x [py, py+1) by an axis-aligned rectangle
+    static float RectCoverage(float px, float py, float left, float top, float right, float bottom) {
+        float overlapX = (std::min)(px + 1.0f, right) - (std::max)(px, left);
+        float overlapY = (std::min)(py + 1.0f, bottom) - (std::max)(py, top);
+        return overlapX > 0.0f && overlapY > 0.0f ? overlapX * overlapY : 0.0f;
+    }
+
+    void MarkDirty(const StampRect& rect) {
+        if (!m_dirty) {
+            m_dirtyRect = rect;
+            m_dirty = true;
+            return;
+        }
+
+        int right = (std::max)(m_dirtyRect.x + m_dirtyRect.width, rect.x + rect.width);
+        int bottom = (std::max)(m_dirtyRect.y + m_dirtyRect.height, rect.y + rect.height);
+        m_dirtyRect.x = (std::min)(m_dirtyRect.x, rect.x);
+        m_dirtyRect.y = (std::min)(m_dirtyRect.y, rect.y);
+        m_dirtyRect.width = right - m_dirtyRect.x;
+        m_dirtyRect.height = bottom - m_dirtyRect.y;
+    }
+
+    void Rasterize(const StampKey& key, const Stamp& stamp) {
+        float halfWidth = key.halfWidth / 4.0f;
+        float halfHeight = key.halfHeight / 4.0f;
+        float halfStroke = key.stroke / 8.0f;
+
+        for (int y = 0; y < stamp.rect.height; ++y) {
+            uint32_t* row = m_pixels.data() + (size_t)(stamp.rect.y + y) * m_width + stamp.rect.x;
+
+            for (int x = 0; x < stamp.rect.width; ++x) {
+                // Pixel corner and center relative to the shape's center
+                float px = x - stamp.originX;
+                float py = y - stamp.originY;
+                float cx = px + 0.5f;
+                float cy = py + 0.5f;
+                float coverage = 0.0f;
+
+                switch ((StampShape)key.shape) {
+                case StampShape::SolidCircle:
+                    coverage = Clamp01(halfWidth - std::sqrt(cx * cx + cy * cy) + 0.5f);
+                    break;
+
+                case StampShape::HollowCircle:
+                    coverage = Clamp01(halfStroke - std::fabs(std::sqrt(cx * cx + cy * cy) - halfWidth) + 0.5f);
+                    break;
+
+                case StampShape::HollowDiamond:
+                    coverage = Clamp01(halfStroke - std::fabs((std::fabs(cx) + std::fabs(cy) - halfWidth) * 0.70710678f) + 0.5f);
+                    break;
+
+                case StampShape::CornerBox:
+                {
+                    // Same eight segments as OverlayWindow::DrawCornerBox, a quarter of each side
+                    float w = halfWidth, h = halfHeight, s = halfStroke;
+                    float qx = halfWidth * 0.5f, qy = halfHeight * 0.5f;
+                    coverage = (std::max)({
+                        RectCoverage(px, py, -w, -h - s, -w + qx, -h + s),
+                        RectCoverage(px, py, w - qx, -h - s, w, -h + s),
+                        RectCoverage(px, py, -w, h - s, -w + qx, h + s),
+                        RectCoverage(px, py, w - qx, h - s, w, h + s),
+                        RectCoverage(px, py, -w - s, -h, -w + s, -h + qy),
+                        RectCoverage(px, py, -w - s, h - qy, -w + s, h),
+                        RectCoverage(px, py, w - s, -h, w + s, -h + qy),
+                        RectCoverage(px, py, w - s, h - qy, w + s, h) });
+                }
+                break;
+                }
+
+                // Premultiplied white: every channel holds the coverage
+                row[x] = (uint32_t)(coverage * 255.0f + 0.5f) * 0x01010101u;
+            }
+        }
+    }
+};
+
+struct StampInstance {
+    const Stamp* stamp;
+    float centerX;
+    float centerY;
+    uint32_t color; // 0xRRGGBBAA, straight alpha
+};
+
+// Per-channel a + (b - a) * weight / 256 on a packed pixel, two channels per multiply
+inline uint32_t LerpPixel(uint32_t a, uint32_t b, uint32_t weight) {
+    uint32_t rb = (((a & 0x00FF00FF) * (256 - weight) + (b & 0x00FF00FF) * weight) >> 8) & 0x00FF00FF;
+    uint32_t ag = ((((a >> 8) & 0x00FF00FF) * (256 - weight) + ((b >> 8) & 0x00FF00FF) * weight) >> 8) & 0x00FF00FF;
+    return rb | (ag << 8);
+}
+
+// x / 255 rounded, exact for 0 <= x <= 65535
+inline uint32_t DivideBy255(uint32_t x) {
+    return ((x + 128) * 257) >> 16;
+}
+
+// Composites a stamp tinted with color (0xRRGGBBAA, straight alpha) onto a premultiplied
+// BGRA surface with source-over blending. The center may be fractional; the stamp is then
+// resampled bilinearly so it moves smoothly instead of snapping to whole pixels. stride
+// is in bytes.
+inline void BlitStamp(uint32_t* target, int targetWidth, int targetHeight, size_t stride,
+    const StampCache& cache, const Stamp& stamp, float centerX, float centerY, uint32_t color) {
+    const uint32_t* atlas = cache.GetPixels();
+    if (!atlas || !target || !(color & 0xFF)) return;
+
+    // Premultiplied tint
+    uint32_t tintA = color & 0xFF;
+    uint32_t tintR = DivideBy255((color >> 24) * tintA);
+    uint32_t tintG = DivideBy255(((color >> 16) & 0xFF) * tintA);
+    uint32_t tintB = DivideBy255(((color >> 8) & 0xFF) * tintA);
+
+    float left = centerX - stamp.originX;
+    float top = centerY - stamp.originY;
+    int baseX = (int)std::floor(left);
+    int baseY = (int)std::floor(top);
+
+    // Weights of the source pixel to the left/above, 0..256
+    uint32_t fx = (uint32_t)((left - baseX) * 256.0f + 0.5f);
+    uint32_t fy = (uint32_t)((top - baseY) * 256.0f + 0.5f);
+    if (fx > 256) fx = 256;
+    if (fy > 256) fy = 256;
+
+    // Output pixel x blends source pixels x-1 and x. The stamp's transparent border means
+    // columns 0 and width (and rows 0 and height) receive nothing, so they are skipped and
+    // every tap stays inside the stamp.
+    int x0 = (std::max)(1, -baseX);
+    int y0 = (std::max)(1, -baseY);
+    int x1 = (std::min)(stamp.rect.width, targetWidth - baseX);
+    int y1 = (std::min)(stamp.rect.height, targetHeight - baseY);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    size_t atlasStride = (size_t)cache.GetWidth();
+    const uint32_t* src = atlas + (size_t)stamp.rect.y * atlasStride + stamp.rect.x;
+
+    for (int y = y0; y < y1; ++y) {
+        uint32_t* row = reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(target) + (size_t)(baseY + y) * stride) + baseX;
+        const uint32_t* above = src + (size_t)(y - 1) * atlasStride;
+        const uint32_t* current = above + atlasStride;
+
+        for (int x = x0; x < x1; ++x) {
+            uint32_t p00 = above[x - 1];
+            uint32_t p10 = above[x];
+            uint32_t p01 = current[x - 1];
+            uint32_t p11 = current[x];
+            if (!(p00 | p10 | p01 | p11)) continue;
+
+            // Bilinear filter: horizontal lerps of both rows, then a vertical lerp. The stamp
+            // is white, so any channel of the result is the coverage.
+            uint32_t coverage = LerpPixel(LerpPixel(p11, p01, fx), LerpPixel(p10, p00, fx), fy) >> 24;
+            if (!coverage) continue;
+
+            uint32_t s = (DivideBy255(coverage * tintA) << 24) | (DivideBy255(coverage * tintR) << 16) |
+                (DivideBy255(coverage * tintG) << 8) | DivideBy255(coverage * tintB);
+
+            // Premultiplied source-over
+            uint32_t inverseAlpha = 255 - (s >> 24);
+            uint32_t d = row[x];
+            uint32_t drb = ((d & 0x00FF00FF) * inverseAlpha + 0x00800080) >> 8;
+            uint32_t dag = (((d >> 8) & 0x00FF00FF) * inverseAlpha + 0x00800080) >> 8;
+            row[x] = s + ((drb & 0x00FF00FF) | ((dag & 0x00FF00FF) << 8));
+        }
+    }
+}
+
+inline void BlitStamps(uint32_t* target, int targetWidth, int targetHeight, size_t stride,
+    const StampCache& cache, const StampInstance* instances, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (instances[i].stamp) {
+            BlitStamp(target, targetWidth, targetHeight, stride, cache, *instances[i].stamp,
+                instances[i].centerX, instances[i].centerY, instances[i].color);
+        }
+    }
+}
@@ -0,0 +1,253 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Startup task graph
+//
+// Background tasks (device factories, fonts, ...) are added with their dependencies
+// and run on a small worker pool as soon as their dependencies have finished.
+// The main thread keeps creating and showing windows meanwhile and only polls
+// IsDone() where it actually needs a result. Every task, main-thread phase and
+// milestone is timed against the pipeline's origin so the whole startup can be
+// reported phase by phase. The origin defaults to construction; pass the process
+// creation time to include loader and runtime start-up.
+class StartupPipeline {
+public:
+    using TaskId = size_t;
+    using Clock = std::chrono::steady_clock;
+
+    struct ReportEntry {
+        std::string name;
+        bool background;
+        bool succeeded;
+        double startMs;
+        double durationMs;
+    };
+
+    explicit StartupPipeline(Clock::time_point origin = Clock::now())
+        : m_origin(origin),
+        m_stopping(false) {
+    }
+
+    ~StartupPipeline() {
+        Stop();
+    }
+
+    StartupPipeline(const StartupPipeline&) = delete;
+    StartupPipeline& operator=(const StartupPipeline&) = delete;
+
+    // Tasks may be added before or after Start(); a task whose dependency failed is
+    // not run and is reported as failed
+    TaskId AddTask(const char* name, std::function<bool()> work, std::initializer_list<TaskId> dependencies = {}) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::unique_ptr<Task> task(new Task());
+        task->name = name;
+        task->work = std::move(work);
+        task->dependencies.assign(dependencies.begin(), dependencies.end());
+        task->state = TaskState::Pending;
+
+        m_tasks.push_back(std::move(task));
+        m_wake.notify_one();
+        return m_tasks.size() - 1;
+    }
+
+    void Start(unsigned workerCount = 0) {
+        if (!m_workers.empty()) return;
+
+        if (workerCount == 0) {
+            workerCount = (std::min)((std::max)(std::thread::hardware_concurrency(), 1u), 4u);
+        }
+
+        for (unsigned i = 0; i < workerCount; ++i) {
+            m_workers.emplace_back(&StartupPipeline::WorkerLoop, this);
+        }
+    }
+
+    // Finishes the tasks that are already running, discards the rest and joins the workers
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+
+        for (std::thread& worker : m_workers) {
+            if (worker.joinable()) worker.join();
+        }
+        m_workers.clear();
+    }
+
+    bool IsDone(TaskId id) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return id < m_tasks.size() && IsFinished(m_tasks[id]->state);
+    }
+
+    bool Succeeded(TaskId id) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return id < m_tasks.size() && m_tasks[id]->state == TaskState::Succeeded;
+    }
+
+    // Blocks until the task has finished; returns whether it succeeded
+    bool Wait(TaskId id) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (id >= m_tasks.size()) return false;
+
+        m_done.wait(lock, [&] { return IsFinished(m_tasks[id]->state) || (m_stopping && m_tasks[id]->state == TaskState::Pending); });
+        return m_tasks[id]->state == TaskState::Succeeded;
+    }
+
+    // Main-thread phases
+    size_t BeginPhase(const char* name) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_report.push_back({ name, false, true, ElapsedMs(), -1.0 });
+        return m_report.size() - 1;
+    }
+
+    void EndPhase(size_t phase, bool succeeded = true) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (phase >= m_report.size()) return;
+
+        m_report[phase].durationMs = ElapsedMs() - m_report[phase].startMs;
+        m_report[phase].succeeded = succeeded;
+    }
+
+    void MarkMilestone(const char* name) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_report.push_back({ name, false, true, ElapsedMs(), 0.0 });
+    }
+
+    // Entries sorted by start time; phases that have not ended have a negative duration
+    std::vector<ReportEntry> GetReport() const {
+        std::vector<ReportEntry> report;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            report = m_report;
+        }
+
+        std::stable_sort(report.begin(), report.end(),
+            [](const ReportEntry& a, const ReportEntry& b) { return a.startMs < b.startMs; });
+        return report;
+    }
+
+    void WriteReport(std::ostream& out) const {
+        std::vector<ReportEntry> report = GetReport();
+
+        double totalMs = 0.0;
+        for (const ReportEntry& entry : report) {
+            totalMs = (std::max)(totalMs, entry.startMs + (std::max)(entry.durationMs, 0.0));
+        }
+
+        char line[256];
+        out << "Startup latency report\n";
+        for (const ReportEntry& entry : report) {
+            snprintf(line, sizeof(line), "  %-28s %-10s start %8.2f ms  duration %8.2f ms%s\n",
+                entry.name.c_str(),
+                entry.background ? "[worker]" : "[main]",
+                entry.startMs,
+                (std::max)(entry.durationMs, 0.0),
+                entry.succeeded ? "" : "  FAILED");
+            out << line;
+        }
+        snprintf(line, sizeof(line), "  %-28s %-10s %8.2f ms\n", "total", "", totalMs);
+        out << line;
+    }
+
+private:
+    enum class TaskState { Pending, Running, Succeeded, Failed };
+
+    struct Task {
+        std::string name;
+        std::function<bool()> work;
+        std::vector<TaskId> dependencies;
+        TaskState state;
+    };
+
+    Clock::time_point m_origin;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::vector<std::unique_ptr<Task>> m_tasks;
+    std::vector<ReportEntry> m_report;
+    std::vector<std::thread> m_workers;
+    bool m_stopping;
+
+    static bool IsFinished(TaskState state) {
+        return state == TaskState::Succeeded || state == TaskState::Failed;
+    }
+
+    double ElapsedMs() const {
+        return std::chrono::duration<double, std::milli>(Clock::now() - m_origin).count();
+    }
+
+    // Returns a runnable task, marking tasks with failed dependencies as failed on the way.
+    // Must be called with m_mutex held.
+    Task* PickTask() {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+
+            for (std::unique_ptr<Task>& task : m_tasks) {
+                if (task->state != TaskState::Pending) continue;
+
+                bool ready = true;
+                bool failed = false;
+                for (TaskId dependency : task->dependencies) {
+                    TaskState state = dependency < m_tasks.size() ? m_tasks[dependency]->state : TaskState::Failed;
+                    if (state == TaskState::Failed) failed = true;
+                    else if (state != TaskState::Succeeded) ready = false;
+                }
+
+                if (failed) {
+                    task->state = TaskState::Failed;
+                    m_report.push_back({ task->name, true, false, ElapsedMs(), 0.0 });
+                    m_done.notify_all();
+                    changed = true;
+                }
+                else if (ready) {
+                    return task.get();
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    void WorkerLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_stopping) {
+            Task* task = PickTask();
+            if (!task) {
+                m_wake.wait(lock);
+                continue;
+            }
+
+            task->state = TaskState::Running;
+            double startMs = ElapsedMs();
+            lock.unlock();
+
+            bool succeeded = task->work ? task->work() : true;
+
+            lock.lock();
+            task->state = succeeded ? TaskState::Succeeded : TaskState::Failed;
+            m_report.push_back({ task->name, true, succeeded, startMs, ElapsedMs() - startMs });
+
+            // Dependents may have become runnable
+            m_wake.notify_all();
+            m_done.notify_all();
+        }
+
+        m_done.notify_all();
+    }
+};
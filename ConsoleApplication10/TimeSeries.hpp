@@ -0,0 +1,287 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TIMESERIES_SSE 1
+#endif
+
+// Fixed-size ring of float samples that any number of threads may append to without
+// locking. A slot is claimed with one fetch_add and published with a sequence number
+// written after the value (seqlock style), so the reader can tell a finished sample from
+// one that is still being written or was overwritten by a producer one lap ahead.
+class TimeSeriesRing {
+public:
+    explicit TimeSeriesRing(size_t capacity)
+        : m_capacity(RoundUpPow2(capacity)),
+        m_mask(m_capacity - 1),
+        m_slots(new Slot[m_capacity]),
+        m_head(0) {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            m_slots[i].sequence.store(0, std::memory_order_relaxed);
+            m_slots[i].value.store(0.0f, std::memory_order_relaxed);
+        }
+    }
+
+    TimeSeriesRing(const TimeSeriesRing&) = delete;
+    TimeSeriesRing& operator=(const TimeSeriesRing&) = delete;
+
+    // Safe from any thread
+    void Push(float value) {
+        uint64_t index = m_head.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = m_slots[index & m_mask];
+
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value.store(value, std::memory_order_relaxed);
+        slot.sequence.store(index + 1, std::memory_order_release);
+    }
+
+    size_t GetCapacity() const { return m_capacity; }
+
+    // Number of slots claimed so far; samples right below it may still be in flight
+    uint64_t GetHead() const { return m_head.load(std::memory_order_acquire); }
+
+    enum class ReadResult { Ready, Pending, Lost };
+
+    // Single reader. Pending: the sample is not written yet. Lost: it was overwritten.
+    ReadResult Read(uint64_t index, float* value) const {
+        const Slot& slot = m_slots[index & m_mask];
+
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        float read = slot.value.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+
+        if (before == index + 1 && after == before) {
+            *value = read;
+            return ReadResult::Ready;
+        }
+
+        // A zero sequence is a write in progress, which is ours unless a lap has passed
+        uint64_t seen = (std::max)(before, after);
+        return (seen > index + 1 || GetHead() - index > m_capacity) ? ReadResult::Lost : ReadResult::Pending;
+    }
+
+    static size_t RoundUpPow2(size_t value) {
+        size_t result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        std::atomic<float> value;
+    };
+
+    size_t m_capacity;
+    size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<uint64_t> m_head;
+};
+
+// Streaming plot data: producers Push() into a TimeSeriesRing from any thread; the render
+// thread calls Update() to move new samples into its own history and then Decimate() to
+// get a min/max envelope per pixel column for the most recent samples.
+//
+// The history keeps min/max summaries of aligned blocks of 32, 1024, ... samples, updated
+// as samples arrive. A column's range is covered by a few block summaries plus contiguous
+// runs at its edges, which are scanned with SIMD, so decimation costs O(columns) rather
+// than O(samples). The x axis is the sample index; samples are assumed evenly spaced.
+class TimeSeriesPlot {
+public:
+    explicit TimeSeriesPlot(size_t capacity = 65536)
+        : m_ring((std::max)(capacity, (size_t)kFanout)),
+        m_consumed(0),
+        m_first(0),
+        m_last(0.0f) {
+        size_t capacitySamples = m_ring.GetCapacity();
+        m_samples.resize(capacitySamples, 0.0f);
+
+        for (size_t blockSize = kFanout; blockSize <= capacitySamples; blockSize *= kFanout) {
+            Level level;
+            level.blockSize = blockSize;
+            level.mins.resize(capacitySamples / blockSize, 0.0f);
+            level.maxs.resize(capacitySamples / blockSize, 0.0f);
+            m_levels.push_back(std::move(level));
+        }
+    }
+
+    // Safe from any thread
+    void Push(float value) {
+        m_ring.Push(value);
+    }
+
+    // Render thread: takes in everything published since the last call
+    void Update() {
+        uint64_t head = m_ring.GetHead();
+        size_t capacity = m_ring.GetCapacity();
+
+        // Fell more than a lap behind: the oldest samples are gone
+        if (head - m_consumed > capacity) {
+            m_consumed = head - capacity;
+            m_first = m_consumed;
+        }
+
+        while (m_consumed < head) {
+            float value;
+            TimeSeriesRing::ReadResult result = m_ring.Read(m_consumed, &value);
+            if (result == TimeSeriesRing::ReadResult::Pending) break;
+
+            // An overwritten sample repeats its predecessor to keep the x axis intact
+            Append(result == TimeSeriesRing::ReadResult::Ready ? value : m_last);
+        }
+    }
+
+    // Samples available to Decimate()
+    size_t GetCount() const {
+        return (size_t)(std::min)(m_consumed - m_first, (uint64_t)m_samples.size());
+    }
+
+    float GetLatest() const { return m_last; }
+
+    // Envelope of the newest sampleCount samples (clamped to GetCount()) over columns
+    // columns. When there are fewer samples than columns, columns between two samples
+    // repeat the nearer earlier one. Returns false when there is nothing to plot.
+    bool Decimate(size_t sampleCount, size_t columns, float* mins, float* maxs) const {
+        size_t count = (std::min)(sampleCount, GetCount());
+        if (!count || !columns) return false;
+
+        uint64_t start = m_consumed - count;
+        for (size_t column = 0; column < columns; ++column) {
+            uint64_t begin = start + (uint64_t)((double)column * count / columns);
+            uint64_t end = start + (uint64_t)((double)(column + 1) * count / columns);
+            if (end <= begin) end = begin + 1;
+
+            RangeMinMax(begin, end, &mins[column], &maxs[column]);
+        }
+
+        return true;
+    }
+
+    // Min and max over the same newest samples, for autoscaling
+    bool GetRange(size_t sampleCount, float* minValue, float* maxValue) const {
+        size_t count = (std::min)(sampleCount, GetCount());
+        if (!count) return false;
+
+        RangeMinMax(m_consumed - count, m_consumed, minValue, maxValue);
+        return true;
+    }
+
+    // Min and max of a contiguous run of floats (mins and maxs may alias)
+    static void MinMaxRun(const float* mins, const float* maxs, size_t count, float* minValue, float* maxValue) {
+        float low = *minValue;
+        float high = *maxValue;
+        size_t i = 0;
+
+#ifdef TIMESERIES_SSE
+        if (count >= 8) {
+            __m128 low4 = _mm_set1_ps(low);
+            __m128 high4 = _mm_set1_ps(high);
+            for (; i + 8 <= count; i += 8) {
+                low4 = _mm_min_ps(low4, _mm_min_ps(_mm_loadu_ps(mins + i), _mm_loadu_ps(mins + i + 4)));
+                high4 = _mm_max_ps(high4, _mm_max_ps(_mm_loadu_ps(maxs + i), _mm_loadu_ps(maxs + i + 4)));
+            }
+
+            float lanes[4];
+            _mm_storeu_ps(lanes, low4);
+            low = (std::min)((std::min)(lanes[0], lanes[1]), (std::min)(lanes[2], lanes[3]));
+            _mm_storeu_ps(lanes, high4);
+            high = (std::max)((std::max)(lanes[0], lanes[1]), (std::max)(lanes[2], lanes[3]));
+        }
+#endif
+
+        for (; i < count; ++i) {
+            low = (std::min)(low, mins[i]);
+            high = (std::max)(high, maxs[i]);
+        }
+
+        *minValue = low;
+        *maxValue = high;
+    }
+
+private:
+    static constexpr size_t kFanout = 32;
+
+    struct Level {
+        size_t blockSize;
+        std::vector<float> mins;
+        std::vector<float> maxs;
+    };
+
+    TimeSeriesRing m_ring;
+    std::vector<float> m_samples;
+    std::vector<Level> m_levels;
+    uint64_t m_consumed; // Absolute index of the next sample to take from the ring
+    uint64_t m_first;    // Oldest absolute index ever kept; older history was skipped
+    float m_last;
+
+    void Append(float value) {
+        uint64_t index = m_consumed++;
+        m_samples[index & (m_samples.size() - 1)] = value;
+        m_last = value;
+
+        // A block is restarted by its first sample, which also drops the previous lap
+        for (Level& level : m_levels) {
+            size_t block = (size_t)((index / level.blockSize) & (level.mins.size() - 1));
+            if (index % level.blockSize == 0) {
+                level.mins[block] = value;
+                level.maxs[block] = value;
+            }
+            else {
+                level.mins[block] = (std::min)(level.mins[block], value);
+                level.maxs[block] = (std::max)(level.maxs[block], value);
+            }
+        }
+    }
+
+    // Scans units [begin, end) of a level (0 is the samples themselves), splitting the
+    // run where it wraps around the end of the ring
+    void ScanLevel(size_t level, uint64_t begin, uint64_t end, float* minValue, float* maxValue) const {
+        if (begin >= end) return;
+
+        const float* mins = level ? m_levels[level - 1].mins.data() : m_samples.data();
+        const float* maxs = level ? m_levels[level - 1].maxs.data() : m_samples.data();
+        size_t size = level ? m_levels[level - 1].mins.size() : m_samples.size();
+
+        size_t first = (size_t)(begin & (size - 1));
+        size_t count = (size_t)(end - begin);
+        size_t head = (std::min)(count, size - first);
+
+        MinMaxRun(mins + first, maxs + first, head, minValue, maxValue);
+        if (count > head) MinMaxRun(mins, maxs, count - head, minValue, maxValue);
+    }
+
+    // Climbs one level while a whole block of the next level fits inside the remaining
+    // range, scanning the uneven ends at the current level on the way up
+    void RangeMinMax(uint64_t begin, uint64_t end, float* minValue, float* maxValue) const {
+        *minValue = (std::numeric_limits<float>::max)();
+        *maxValue = -(std::numeric_limits<float>::max)();
+
+        size_t level = 0;
+        uint64_t unit = 1;
+        while (level < m_levels.size()) {
+            uint64_t nextUnit = m_levels[level].blockSize;
+            uint64_t alignedBegin = (begin + nextUnit - 1) / nextUnit * nextUnit;
+            uint64_t alignedEnd = end / nextUnit * nextUnit;
+            if (alignedBegin >= alignedEnd) break;
+
+            ScanLevel(level, begin / unit, alignedBegin / unit, minValue, maxValue);
+            ScanLevel(level, alignedEnd / unit, end / unit, minValue, maxValue);
+            begin = alignedBegin;
+            end = alignedEnd;
+            unit = nextUnit;
+            level++;
+        }
+
+        ScanLevel(level, begin / unit, end / unit, minValue, maxValue);
+    }
+};
@@ -20,37 +20,148 @@
 #include "CloneWindow.hpp"
 #include "OverlayWindow.hpp"  // Now using our Direct2D-based OverlayWindow
 
+// Main loop iteration times in milliseconds, plotted when --frame-plot is given
+TimeSeriesPlot* g_pFramePlot = nullptr;
+
+// The --zoom-pane pane, whose copy of the centre circle is drawn in its own coordinates
+CloneWindow* g_pCloneWindow = nullptr;
+size_t g_zoomPane = 0;
+
+// When the process was created, on the steady clock the startup report uses
+StartupPipeline::Clock::time_point GetProcessStartTime() {
+    StartupPipeline::Clock::time_point now = StartupPipeline::Clock::now();
+
+    FILETIME creation, exitTime, kernelTime, userTime, current;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernelTime, &userTime)) return now;
+    GetSystemTimeAsFileTime(&current);
+
+    // FILETIME counts 100 ns units
+    ULARGE_INTEGER created, present;
+    created.LowPart = creation.dwLowDateTime;
+    created.HighPart = creation.dwHighDateTime;
+    present.LowPart = current.dwLowDateTime;
+    present.HighPart = current.dwHighDateTime;
+    if (present.QuadPart < created.QuadPart) return now;
+
+    return now - std::chrono::duration_cast<StartupPipeline::Clock::duration>(
+        std::chrono::nanoseconds((present.QuadPart - created.QuadPart) * 100));
+}
+
 // Custom draw function - updated for Direct2D
 void CustomDraw(OverlayWindow* Overlay, int Width, int Height) {
     Overlay->DrawHollowCircle({ Width / 2.f, Height / 2.f }, 100.f, 1.f, D2D1::ColorF(1.0, 1.0, 1.0, 0.4));
+
+    PaneTransform zoom;
+    if (g_pCloneWindow && g_zoomPane && g_pCloneWindow->GetPaneTransform(g_zoomPane, &zoom)) {
+        Overlay->SetPaneSpace(&zoom);
+        Overlay->DrawHollowCircle({ Width / 2.f, Height / 2.f }, 100.f, 1.f, D2D1::ColorF(1.0, 1.0, 1.0, 0.4));
+        Overlay->SetPaneSpace(nullptr);
+    }
+
+    if (g_pFramePlot) {
+        D2D1_RECT_F plotRect = D2D1::RectF(10.f, Height - 70.f, 310.f, Height - 10.f);
+        Overlay->DrawPlot(*g_pFramePlot, plotRect, 3000, 0.f, 33.3f, PlotStyle::Band, 1.f, D2D1::ColorF(0.2f, 1.0f, 0.4f, 0.6f));
+    }
 }
 
 int main(int argc, char* argv[]) {
+    // Offline scene compilation: --compile-scene <input.txt> <output.ovs>
+    if (argc == 4 && strcmp(argv[1], "--compile-scene") == 0) {
+        std::string error;
+        if (!OverlaySceneCompiler::CompileFile(argv[2], argv[3], &error)) {
+            std::cerr << "Failed to compile scene: " << error << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Device and font creation runs on these workers while the windows are created.
+    // The report is timed from process creation.
+    StartupPipeline startup(GetProcessStartTime());
+    startup.Start();
+
+    const char* scenePath = nullptr;
+    bool predictMotion = false;
+    bool reportLatency = false;
+    double frameBudgetMs = 0.0;
+    bool plotFrameTimes = false;
+    bool zoomPane = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) scenePath = argv[++i];
+        else if (strcmp(argv[i], "--predict") == 0) predictMotion = true;
+        else if (strcmp(argv[i], "--latency-report") == 0) reportLatency = true;
+        else if (strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc) frameBudgetMs = atof(argv[++i]);
+        else if (strcmp(argv[i], "--frame-plot") == 0) plotFrameTimes = true;
+        else if (strcmp(argv[i], "--zoom-pane") == 0) zoomPane = true;
+    }
+
     timeBeginPeriod(1);
     SetProcessDpiAwareness(PROCESS_PER_MONITOR_DPI_AWARE);
     
     // Create clone window
     CloneWindow cloneWindow((HWND)FindWindowA("UnrealWindow", NULL));
 
+    // Magnified centre of the source in the top-right corner: --zoom-pane
+    if (zoomPane) {
+        PaneSpec zoom;
+        zoom.sourceLeft = 0.4f;
+        zoom.sourceTop = 0.4f;
+        zoom.sourceRight = 0.6f;
+        zoom.sourceBottom = 0.6f;
+        zoom.destLeft = 0.7f;
+        zoom.destTop = 0.0f;
+        zoom.destRight = 1.0f;
+        zoom.destBottom = 0.3f;
+        g_zoomPane = cloneWindow.AddPane(zoom);
+        g_pCloneWindow = &cloneWindow;
+    }
+
+    size_t phase = startup.BeginPhase("clone window");
     if (!cloneWindow.Create(GetModuleHandleA(0), SW_SHOW)) {
         std::cerr << "Failed to create clone window." << std::endl;
         return 1;
     }
+    startup.EndPhase(phase);
 
     // Create overlay window
     OverlayWindow overlayWindow(cloneWindow.GetWindowHandle());
-    if (!overlayWindow.Create()) {
+    phase = startup.BeginPhase("overlay window");
+    if (!overlayWindow.Create(&startup)) {
         std::cerr << "Failed to create overlay window." << std::endl;
         return 1;
     }
+    startup.EndPhase(phase);
 
     // Set custom draw callback
     overlayWindow.SetDrawCallback(CustomDraw);
 
+    // Optional static scene: --scene <file.ovs>
+    OverlaySceneFile sceneFile;
+    if (scenePath) {
+        if (!sceneFile.Open(scenePath)) {
+            std::cerr << "Failed to load scene " << scenePath << std::endl;
+            return 1;
+        }
+        overlayWindow.SetScene(&sceneFile.GetView());
+    }
+
+    // Cursor and tracked-element extrapolation: --predict
+    overlayWindow.SetMotionPrediction(predictMotion);
+
+    // Quality governor budget: --frame-budget <ms>
+    if (frameBudgetMs > 0.0) overlayWindow.SetFrameBudget((int64_t)(frameBudgetMs * 1000.0));
+
+    // Frame time plot: --frame-plot
+    TimeSeriesPlot framePlot(4096);
+    if (plotFrameTimes) g_pFramePlot = &framePlot;
+
     // Initial update of overlay position
     overlayWindow.UpdatePosition(cloneWindow.GetThumbnailRect());
 
     // Main message loop
+    bool startupReported = false;
+    int64_t nextLatencyReportUs = LatencyClock::NowUs() + 5000000;
+    int64_t lastIterationUs = 0;
     bool done = false;
     MSG msg;
     ZeroMemory(&msg, sizeof(msg));
@@ -66,13 +177,43 @@ int main(int argc, char* argv[]) {
 
         if (done) break;
 
+        // Under the governor's refresh cap, sleep until the next frame slot or the next message
+        int64_t waitUs = overlayWindow.GetTimeUntilNextFrameUs();
+        if (waitUs > 0) {
+            MsgWaitForMultipleObjects(0, NULL, FALSE, (DWORD)((waitUs + 999) / 1000), QS_ALLINPUT);
+            continue;
+        }
+
         // Get relative mouse position and update overlay
+        int64_t inputTimeUs = LatencyClock::NowUs();
+        if (lastIterationUs) framePlot.Push((inputTimeUs - lastIterationUs) / 1000.0f);
+        lastIterationUs = inputTimeUs;
+
         POINT relativeMousePos = cloneWindow.GetRelativeMousePosition();
         bool cursorVisible = cloneWindow.IsMouseCursorVisible() && cloneWindow.IsMouseInSourceWindow();
-        overlayWindow.UpdateMouseInfo(relativeMousePos, cursorVisible);
+        overlayWindow.UpdateMouseInfo(relativeMousePos, cursorVisible, inputTimeUs);
 
         overlayWindow.UpdatePosition(cloneWindow.GetThumbnailRect());
-        overlayWindow.Render();
+        bool presented = overlayWindow.Render();
+
+        if (!startupReported && presented) {
+            startup.MarkMilestone("first overlay frame");
+            startup.WriteReport(std::cout);
+            startupReported = true;
+        }
+
+        // Latency distributions every 5 seconds: --latency-report
+        if (reportLatency && inputTimeUs >= nextLatencyReportUs) {
+            overlayWindow.GetInputToPresentLatency().WriteReport(std::cout, "input-to-present");
+            overlayWindow.GetInputToPhotonLatency().WriteReport(std::cout, "input-to-photon");
+            nextLatencyReportUs = inputTimeUs + 5000000;
+        }
+
+        if (overlayWindow.IsDeviceFailed()) {
+            startup.WriteReport(std::cerr);
+            std::cerr << "Failed to initialize overlay rendering." << std::endl;
+            return 1;
+        }
     }
 
     return (int)msg.wParam;
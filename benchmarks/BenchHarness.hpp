@@ -0,0 +1,62 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Minimal benchmark helpers. Measure() runs a body repeatedly and reports the median
+// time per run, which is less sensitive to scheduler noise than the mean. With --quick
+// every benchmark runs a handful of iterations only, so ctest can smoke-test them.
+
+inline bool& BenchQuick() {
+    static bool quick = false;
+    return quick;
+}
+
+inline void BenchInit(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--quick") == 0) BenchQuick() = true;
+    }
+}
+
+// Scales an iteration count down for --quick runs
+inline int BenchIterations(int iterations) {
+    return BenchQuick() ? (std::min)(iterations, 3) : iterations;
+}
+
+inline double BenchNowUs() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Median microseconds per call of body over the given number of runs
+template <typename Body>
+double Measure(int runs, Body body) {
+    runs = (std::max)(BenchIterations(runs), 1);
+
+    std::vector<double> times;
+    times.reserve(runs);
+    for (int i = 0; i < runs; ++i) {
+        double start = BenchNowUs();
+        body();
+        times.push_back(BenchNowUs() - start);
+    }
+
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+inline void Report(const char* name, double microseconds, const char* extra = "") {
+    std::printf("%-48s %12.2f us  %s\n", name, microseconds, extra);
+}
+
+// Keeps the optimizer from discarding a result
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif
+}
@@ -0,0 +1,58 @@
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "CommandList.hpp"
+
+// Frame recording with ParallelRecorder at several thread counts. Each job does some
+// per-command math, as a draw callback projecting tracked objects would, and a few jobs
+// use z keys so the merge takes its k-way path.
+
+static void AddJobs(ParallelRecorder& recorder, int jobs, int commandsPerJob) {
+    for (int job = 0; job < jobs; ++job) {
+        recorder.AddJob([job, commandsPerJob](CommandList& list, int width, int height) {
+            for (int i = 0; i < commandsPerJob; ++i) {
+                float angle = (float)(job * commandsPerJob + i) * 0.001f;
+                float x = width * 0.5f + std::sin(angle) * std::cos(angle * 3.0f) * width * 0.45f;
+                float y = height * 0.5f + std::cos(angle) * std::sin(angle * 5.0f) * height * 0.45f;
+                if (job % 4 == 0) list.SetZ(i % 3);
+                list.DrawHollowDiamond(x, y, 6.0f, 1.5f, CommandList::Rgba(0.2f, 1.0f, 0.4f, 0.8f)).id = (uint32_t)(job << 16 | i);
+            }
+        }, job % 2);
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchInit(argc, argv);
+
+    std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+
+    for (int commandsPerJob : { 100, 2000 }) {
+        const int jobs = 32;
+        double singleUs = 0.0;
+
+        for (unsigned threads : { 1u, 2u, 4u, 8u }) {
+            if (BenchQuick() && threads > 2) break;
+
+            ParallelRecorder recorder(threads);
+            AddJobs(recorder, jobs, commandsPerJob);
+
+            std::vector<OverlayPrimitive> frame;
+            recorder.Record(1920, 1080, frame); // Starts the workers
+            double us = Measure(50, [&] {
+                recorder.Record(1920, 1080, frame);
+                DoNotOptimize(frame.data());
+            });
+            if (threads == 1) singleUs = us;
+
+            char name[64], extra[64];
+            std::snprintf(name, sizeof(name), "record %dk commands, %u thread%s", jobs * commandsPerJob / 1000, threads, threads > 1 ? "s" : "");
+            std::snprintf(extra, sizeof(extra), "%.2fx of 1 thread", singleUs / us);
+            Report(name, us, extra);
+        }
+    }
+
+    return 0;
+}
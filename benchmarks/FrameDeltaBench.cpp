@@ -0,0 +1,104 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "FrameDelta.hpp"
+
+// Encoded size and encode/decode time per frame for typical overlay workloads. Raw size is
+// the primitives written out field by field (36 bytes plus two per UTF-16 code unit).
+
+struct Workload {
+    const char* name;
+    float moving;   // Fraction of markers that move each frame
+    float churn;    // Fraction of markers replaced each frame
+};
+
+static size_t RawSize(const std::vector<OverlayPrimitive>& frame) {
+    size_t bytes = 0;
+    for (const OverlayPrimitive& primitive : frame) bytes += 36 + primitive.text.size() * 2;
+    return bytes;
+}
+
+int main(int argc, char** argv) {
+    BenchInit(argc, argv);
+
+    const size_t markers = 2000;
+    const int frames = BenchIterations(300);
+    const Workload workloads[] = {
+        { "static scene", 0.0f, 0.0f },
+        { "10% tracked markers moving", 0.1f, 0.0f },
+        { "all markers moving", 1.0f, 0.0f },
+        { "all moving, 2% churn", 1.0f, 0.02f },
+    };
+
+    for (const Workload& workload : workloads) {
+        std::mt19937 random(9);
+        std::uniform_real_distribution<float> position(0.0f, 1920.0f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        std::vector<OverlayPrimitive> frame(markers);
+        uint32_t nextId = 0;
+        for (OverlayPrimitive& primitive : frame) {
+            primitive.id = nextId++;
+            primitive.type = (uint16_t)SceneElementType::HollowDiamond;
+            primitive.color = 0x40FF40C0u;
+            primitive.x0 = position(random);
+            primitive.y0 = position(random) * 0.5625f;
+            primitive.size = 8.0f;
+            primitive.stroke = 1.5f;
+        }
+
+        // A few labels whose text changes every frame
+        for (size_t i = 0; i < 20; ++i) frame[i * 97].type = (uint16_t)SceneElementType::Text;
+
+        FrameDeltaEncoder encoder(120);
+        FrameDeltaDecoder decoder;
+        std::vector<uint8_t> encoded;
+        size_t encodedBytes = 0, rawBytes = 0;
+        double encodeUs = 0.0, decodeUs = 0.0;
+
+        for (int f = 0; f < frames; ++f) {
+            for (size_t i = 0; i < markers; ++i) {
+                OverlayPrimitive& primitive = frame[i];
+                if (unit(random) < workload.churn) {
+                    primitive.id = nextId++;
+                    primitive.x0 = position(random);
+                    primitive.y0 = position(random) * 0.5625f;
+                }
+                else if (unit(random) < workload.moving) {
+                    primitive.x0 += std::sin(f * 0.05f + i) * 1.3f;
+                    primitive.y0 += std::cos(f * 0.05f + i) * 1.3f;
+                }
+                if (primitive.type == (uint16_t)SceneElementType::Text) primitive.text = L"dist " + std::to_wstring(f / 10 + i);
+            }
+
+            encoded.clear();
+            double start = BenchNowUs();
+            encoder.Encode(frame, encoded);
+            double middle = BenchNowUs();
+            bool decoded = decoder.Decode(encoded.data(), encoded.size());
+            double end = BenchNowUs();
+
+            DoNotOptimize(decoded);
+            encodeUs += middle - start;
+            decodeUs += end - middle;
+            encodedBytes += encoded.size();
+            rawBytes += RawSize(frame);
+        }
+
+        char name[64], extra[96];
+        std::snprintf(name, sizeof(name), "encode 2k: %s", workload.name);
+        std::snprintf(extra, sizeof(extra), "%.0f B/frame, %.1fx smaller than raw", (double)encodedBytes / frames,
+            (double)rawBytes / encodedBytes);
+        Report(name, encodeUs / frames, extra);
+
+        std::snprintf(name, sizeof(name), "decode 2k: %s", workload.name);
+        std::snprintf(extra, sizeof(extra), "%.0f MB/s of raw frames", rawBytes / decodeUs);
+        Report(name, decodeUs / frames, extra);
+    }
+
+    return 0;
+}
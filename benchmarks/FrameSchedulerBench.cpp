@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "FrameScheduler.hpp"
+
+// Scheduling latency and overhead: how long a task waits between co_await OnWorker() and
+// running on a worker, what resuming a frame task costs inside RunFrame(), and how fast a
+// burst of worker hops drains.
+
+static FrameTask TimedHop(FrameScheduler& scheduler, std::vector<double>& latencies, size_t index, std::atomic<int>& done) {
+    double start = BenchNowUs();
+    co_await scheduler.OnWorker();
+    latencies[index] = BenchNowUs() - start;
+    done++;
+}
+
+static FrameTask Looping(FrameScheduler& scheduler, std::atomic<bool>& stop) {
+    while (!stop) co_await scheduler.NextFrame();
+}
+
+static FrameTask Hop(FrameScheduler& scheduler, std::atomic<int>& done) {
+    co_await scheduler.OnWorker();
+    done++;
+}
+
+static double PercentileOf(std::vector<double> values, double p) {
+    size_t index = (size_t)(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+int main(int argc, char** argv) {
+    BenchInit(argc, argv);
+
+    // Hop latency with an idle pool: one task at a time
+    {
+        FrameScheduler scheduler(2);
+        size_t hops = BenchQuick() ? 20 : 2000;
+        std::vector<double> latencies(hops);
+        std::atomic<int> done(0);
+
+        for (size_t i = 0; i < hops; ++i) {
+            scheduler.Spawn(TimedHop(scheduler, latencies, i, done));
+            scheduler.RunFrame(1000);
+            while (done != (int)i + 1) std::this_thread::yield();
+        }
+
+        char extra[64];
+        std::snprintf(extra, sizeof(extra), "p99 %.2f us", PercentileOf(latencies, 0.99));
+        Report("OnWorker hop latency, idle pool (p50)", PercentileOf(latencies, 0.5), extra);
+    }
+
+    // Resume cost of frame tasks inside RunFrame()
+    for (int tasks : { 100, 10000 }) {
+        if (BenchQuick() && tasks > 100) break;
+
+        FrameScheduler scheduler(0);
+        std::atomic<bool> stop(false);
+        for (int i = 0; i < tasks; ++i) scheduler.Spawn(Looping(scheduler, stop));
+        scheduler.RunFrame(1000000);
+
+        double frameUs = Measure(50, [&] { scheduler.RunFrame(1000000); });
+
+        char extra[64];
+        std::snprintf(extra, sizeof(extra), "%.1f ns/task", frameUs * 1000.0 / tasks);
+        Report(tasks == 100 ? "RunFrame, 100 NextFrame tasks" : "RunFrame, 10k NextFrame tasks", frameUs, extra);
+
+        stop = true;
+        scheduler.RunFrame(1000000);
+    }
+
+    // A burst of worker hops drained by four workers
+    {
+        int tasks = BenchQuick() ? 200 : 2000;
+        double burstUs = Measure(20, [&] {
+            FrameScheduler scheduler(4);
+            std::atomic<int> done(0);
+            for (int i = 0; i < tasks; ++i) scheduler.Spawn(Hop(scheduler, done));
+            while (scheduler.GetLiveTaskCount()) scheduler.RunFrame(1000);
+        });
+
+        char extra[64];
+        std::snprintf(extra, sizeof(extra), "%d tasks, %.2f us/task", tasks, burstUs / tasks);
+        Report("OnWorker burst, 4 workers", burstUs, extra);
+    }
+
+    return 0;
+}
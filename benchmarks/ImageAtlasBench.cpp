@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "ImageAtlas.hpp"
+
+// Building mip chains when images are added, and the CPU blit of icons at the sizes an
+// overlay draws them: shrunk (mip level plus bilinear), at their own size and enlarged.
+
+int main(int argc, char** argv) {
+    BenchInit(argc, argv);
+
+    std::mt19937 random(4);
+    std::vector<uint32_t> icon(64 * 64);
+    for (uint32_t& pixel : icon) pixel = random() | 0x40000000u;
+    std::vector<uint32_t> large(512 * 512);
+    for (uint32_t& pixel : large) pixel = random();
+
+    double addUs = Measure(20, [&] {
+        ImageAtlas atlas;
+        for (int i = 0; i < 64; ++i) DoNotOptimize(atlas.AddImage(icon.data(), 64, 64, 64 * sizeof(uint32_t)));
+    });
+    Report("add 64 icons of 64x64 with mips", addUs);
+
+    double addLargeUs = Measure(20, [&] {
+        ImageAtlas atlas;
+        DoNotOptimize(atlas.AddImage(large.data(), 512, 512, 512 * sizeof(uint32_t)));
+    });
+    Report("add one 512x512 image with mips", addLargeUs);
+
+    // Source and target share the stride, as levels in the atlas do
+    std::vector<uint32_t> half(512 * 256);
+    double downsampleUs = Measure(50, [&] {
+        ImageAtlas::BoxDownsample(large.data(), 512, 512, half.data(), 256, 256, 512);
+        DoNotOptimize(half[0]);
+    });
+    Report("box downsample 512x512 to 256x256", downsampleUs);
+
+    ImageAtlas atlas;
+    ImageId id = atlas.AddImage(icon.data(), 64, 64, 64 * sizeof(uint32_t));
+
+    const int width = 1920, height = 1080, count = 1000;
+    std::vector<uint32_t> target((size_t)width * height, 0xFF202020u);
+    struct Case { const char* name; float size; };
+    const Case cases[] = { { "blit 1k icons at 24 px", 24.0f }, { "blit 1k icons at 64 px", 64.0f }, { "blit 1k icons at 96 px", 96.0f } };
+
+    for (const Case& test : cases) {
+        double blitUs = Measure(10, [&] {
+            for (int i = 0; i < count; ++i) {
+                float x = (float)(i * 37 % (width - 100)) + 0.3f;
+                float y = (float)(i * 53 % (height - 100)) + 0.6f;
+                BlitImage(target.data(), width, height, width * sizeof(uint32_t), atlas, id, x, y, x + test.size, y + test.size);
+            }
+        });
+
+        char extra[64];
+        std::snprintf(extra, sizeof(extra), "level %d, %.1f ns/pixel", atlas.SelectLevel(id, test.size, test.size),
+            blitUs * 1000.0 / (count * test.size * test.size));
+        Report(test.name, blitUs, extra);
+    }
+
+    DoNotOptimize(target[0]);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "OverlayScene.hpp"
+
+// Compile, map and walk times for scenes of increasing size. Mapping only validates the
+// header, so it should stay flat as the scene grows; walking touches every record.
+
+static std::string MakeSceneText(int elements) {
+    std::ostringstream text;
+    text << "canvas 1920 1080\n";
+    for (int i = 0; i < elements; ++i) {
+        float x = (float)(i * 37 % 1920);
+        float y = (float)(i * 53 % 1080);
+        switch (i % 4) {
+        case 0: text << "circle " << x << ' ' << y << " 4 #ff0000\n"; break;
+        case 1: text << "ring " << x << ' ' << y << " 6 1.5 #00ff00 low\n"; break;
+        case 2: text << "line " << x << ' ' << y << ' ' << x + 20 << ' ' << y + 10 << " 1 #0000ff\n"; break;
+        default: text << "text " << x << ' ' << y << " 12 #ffffff \"label " << i << "\"\n"; break;
+        }
+    }
+    return text.str();
+}
+
+int main(int argc, char** argv) {
+    BenchInit(argc, argv);
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "overlay_scene_bench.ovs";
+
+    for (int elements : { 1000, 10000, 100000 }) {
+        if (BenchQuick() && elements > 1000) break;
+
+        std::string text = MakeSceneText(elements);
+        std::vector<uint8_t> blob;
+
+        double compileUs = Measure(5, [&] {
+            std::istringstream input(text);
+            OverlaySceneCompiler::Compile(input, blob);
+        });
+
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(blob.data()), (std::streamsize)blob.size());
+        }
+
+        double mapUs = Measure(50, [&] {
+            OverlaySceneFile scene;
+            scene.Open(path.string().c_str());
+            DoNotOptimize(scene.GetView().GetElementCount());
+        });
+
+        OverlaySceneFile scene;
+        if (!scene.Open(path.string().c_str())) {
+            std::fprintf(stderr, "cannot map %s\n", path.string().c_str());
+            return 1;
+        }
+
+        // Stands in for DrawScene: every record is read and text references are resolved
+        double walkUs = Measure(50, [&] {
+            const OverlaySceneView& view = scene.GetView();
+            const SceneElement* records = view.GetElements();
+            float sum = 0.0f;
+            for (uint32_t i = 0; i < view.GetElementCount(); ++i) {
+                sum += records[i].x0 + records[i].size;
+                if (records[i].type == (uint16_t)SceneElementType::Text) sum += view.GetText(records[i]) ? 1.0f : 0.0f;
+            }
+            DoNotOptimize(sum);
+        });
+
+        char label[64];
+        char extra[64];
+        std::snprintf(extra, sizeof(extra), "%zu bytes", blob.size());
+        std::snprintf(label, sizeof(label), "compile %d elements", elements);
+        Report(label, compileUs, extra);
+        std::snprintf(label, sizeof(label), "map and attach %d elements", elements);
+        Report(label, mapUs);
+        std::snprintf(label, sizeof(label), "walk %d elements", elements);
+        Report(label, walkUs);
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "SpatialGrid.hpp"
+
+// Per-frame update cost of 50k hover targets on a 1920x1080 overlay with 32 px cells (as
+// OverlayWindow uses it), plus query and label placement costs. One frame is
+// BeginFrame(), a Move() per element and RemoveStale().
+
+static const int kElements = 50000;
+
+static std::vector<SpatialRect> MakeRects(std::mt19937& random) {
+    std::uniform_real_distribution<float> x(0.0f, 1880.0f), y(0.0f, 1040.0f), size(8.0f, 40.0f);
+    std::vector<SpatialRect> rects(kElements);
+    for (SpatialRect& rect : rects) {
+        float left = x(random), top = y(random);
+        rect = { left, top, left + size(random), top + size(random) };
+    }
+    return rects;
+}
+
+int main(int argc, char** argv) {
+    BenchInit(argc, argv);
+    std::mt19937 random(42);
+    std::vector<SpatialRect> rects = MakeRects(random);
+
+    SpatialGrid grid(32.0f);
+    std::vector<SpatialGrid::Handle> handles(kElements);
+    for (int i = 0; i < kElements; ++i) handles[i] = grid.Insert(rects[i], (uint32_t)i + 1);
+
+    auto frame = [&](auto update) {
+        grid.BeginFrame();
+        for (int i = 0; i < kElements; ++i) grid.Move(handles[i], update(i));
+        grid.RemoveStale();
+    };
+
+    // Static content: every rectangle is re-submitted unchanged
+    double staticUs = Measure(100, [&] { frame([&](int i) { return rects[i]; }); });
+    Report("50k updates, unchanged", staticUs);
+
+    // Sub-pixel jitter: rectangles change but stay in their cells almost always
+    int tick = 0;
+    double jitterUs = Measure(100, [&] {
+        float offset = (tick++ & 1) ? 0.25f : 0.0f;
+        frame([&](int i) { return SpatialRect{ rects[i].left + offset, rects[i].top, rects[i].right + offset, rects[i].bottom }; });
+    });
+    Report("50k updates, sub-pixel jitter", jitterUs);
+
+    // Everything moving 2 px per frame, crossing a cell every 16 frames
+    float drift = 0.0f;
+    double movingUs = Measure(100, [&] {
+        drift += 2.0f;
+        if (drift > 64.0f) drift = 0.0f;
+        frame([&](int i) { return SpatialRect{ rects[i].left + drift, rects[i].top, rects[i].right + drift, rects[i].bottom }; });
+    });
+    Report("50k updates, all moving 2 px", movingUs);
+
+    // A tenth of the targets disappear each frame and come back the next
+    double churnUs = Measure(50, [&] {
+        grid.BeginFrame();
+        for (int i = 0; i < kElements; ++i) {
+            if (i % 10) grid.Move(handles[i], rects[i]);
+            else if (!grid.IsLive(handles[i])) handles[i] = grid.Insert(rects[i], (uint32_t)i + 1);
+        }
+        grid.RemoveStale();
+    });
+    Report("50k updates, 10% churn", churnUs);
+
+    std::uniform_real_distribution<float> px(0.0f, 1920.0f), py(0.0f, 1080.0f);
+    std::vector<float> points(20000);
+    for (float& p : points) p = px(random);
+
+    double hitUs = Measure(50, [&] {
+        for (size_t i = 0; i + 1 < points.size(); i += 2) DoNotOptimize(grid.HitTest(points[i], points[i + 1] * 0.5625f));
+    });
+    Report("10k hit tests", hitUs);
+
+    double queryUs = Measure(50, [&] {
+        size_t found = 0;
+        for (size_t i = 0; i + 1 < points.size(); i += 2) {
+            float x = points[i], y = points[i + 1] * 0.5625f;
+            grid.QueryRect({ x, y, x + 60.0f, y + 20.0f }, [&](SpatialGrid::Handle) { found++; return true; });
+        }
+        DoNotOptimize(found);
+    });
+    Report("10k 60x20 rect queries", queryUs);
+
+    SpatialGrid labels(32.0f);
+    double labelUs = Measure(50, [&] {
+        labels.Clear();
+        for (int i = 0; i < 5000; ++i) {
+            SpatialRect rect = { rects[i].left, rects[i].top, rects[i].left + 60.0f, rects[i].top + 14.0f };
+            if (!labels.AnyOverlap(rect)) labels.Insert(rect, 0);
+        }
+    });
+    Report("place 5k labels", labelUs);
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "TimeSeries.hpp"
+
+// Per-frame cost of the plot: taking in new samples and decimating the visible window to
+// one min/max pair per pixel column, compared with a plain scan of the same samples.
+
+static void NaiveDecimate(const std::vector<float>& samples, size_t count, size_t columns, float* mins, float* maxs) {
+    size_t start = samples.size() - count;
+    for (size_t column = 0; column < columns; ++column) {
+        size_t begin = start + column * count / columns;
+        size_t end = (std::max)(start + (column + 1) * count / columns, begin + 1);
+
+        float low = samples[begin], high = samples[begin];
+        for (size_t i = begin + 1; i < end; ++i) {
+            low = (std::min)(low, samples[i]);
+            high = (std::max)(high, samples[i]);
+        }
+        mins[column] = low;
+        maxs[column] = high;
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchInit(argc, argv);
+
+    const size_t capacity = (size_t)1 << 20;
+    std::mt19937 random(3);
+    std::normal_distribution<float> noise(16.7f, 2.0f);
+
+    std::vector<float> samples(capacity);
+    for (float& sample : samples) sample = noise(random);
+
+    TimeSeriesPlot plot(capacity);
+    double fillUs = Measure(5, [&] {
+        for (float sample : samples) plot.Push(sample);
+        plot.Update();
+    });
+    char extra[64];
+    std::snprintf(extra, sizeof(extra), "%.1f ns/sample", fillUs * 1000.0 / capacity);
+    Report("push + update 1M samples", fillUs, extra);
+
+    // One frame's worth of new samples at a high producer rate
+    double frameUs = Measure(200, [&] {
+        for (int i = 0; i < 1000; ++i) plot.Push(samples[i]);
+        plot.Update();
+    });
+    Report("push + update 1k samples", frameUs);
+
+    std::vector<float> mins(1920), maxs(1920);
+    for (size_t count : { (size_t)4096, (size_t)65536, capacity }) {
+        if (BenchQuick() && count > 65536) break;
+
+        for (size_t columns : { (size_t)300, (size_t)1920 }) {
+            double decimateUs = Measure(50, [&] {
+                plot.Decimate(count, columns, mins.data(), maxs.data());
+                DoNotOptimize(mins[0]);
+            });
+            double naiveUs = Measure(10, [&] {
+                NaiveDecimate(samples, count, columns, mins.data(), maxs.data());
+                DoNotOptimize(mins[0]);
+            });
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "decimate %zuk samples to %zu columns", count / 1024, columns);
+            std::snprintf(extra, sizeof(extra), "naive scan %.2f us", naiveUs);
+            Report(name, decimateUs, extra);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "CommandList.hpp"
+#include "TestHarness.hpp"
+
+// Jobs record commands whose id encodes (job, index), with z keys that jump around, and
+// some of them take longer than others so they finish in a different order every run.
+
+static uint32_t CommandId(size_t job, size_t index) {
+    return (uint32_t)(job << 16 | index);
+}
+
+struct JobPlan {
+    int32_t initialZ;
+    std::vector<int32_t> keys; // z before each command
+    int spin;
+};
+
+static std::vector<JobPlan> MakePlans(uint32_t seed, size_t jobs, int32_t zRange) {
+    std::mt19937 random(seed);
+    std::vector<JobPlan> plans(jobs);
+    for (JobPlan& plan : plans) {
+        plan.initialZ = (int32_t)(random() % zRange);
+        plan.keys.resize(random() % 60);
+        for (int32_t& key : plan.keys) key = random() % 4 == 0 ? (int32_t)(random() % zRange) - 1 : -1000; // -1000: keep the z
+        plan.spin = (int)(random() % 20000);
+    }
+    return plans;
+}
+
+static void AddPlans(ParallelRecorder& recorder, const std::vector<JobPlan>& plans) {
+    for (size_t job = 0; job < plans.size(); ++job) {
+        const JobPlan* plan = &plans[job];
+        recorder.AddJob([plan, job](CommandList& list, int width, int) {
+            volatile int sink = 0;
+            for (int i = 0; i < plan->spin; ++i) sink = sink + i;
+
+            for (size_t i = 0; i < plan->keys.size(); ++i) {
+                if (plan->keys[i] != -1000) list.SetZ(plan->keys[i]);
+                list.DrawSolidCircle((float)(i % width), (float)job, 3.0f, 0xFFFFFFFFu).id = CommandId(job, i);
+            }
+        }, plan->initialZ);
+    }
+}
+
+// (z, job, index) order, worked out directly from the plans
+static std::vector<uint32_t> ExpectedOrder(const std::vector<JobPlan>& plans) {
+    std::vector<std::tuple<int32_t, size_t, size_t>> keyed;
+    for (size_t job = 0; job < plans.size(); ++job) {
+        int32_t z = plans[job].initialZ;
+        for (size_t i = 0; i < plans[job].keys.size(); ++i) {
+            if (plans[job].keys[i] != -1000) z = plans[job].keys[i];
+            keyed.emplace_back(z, job, i);
+        }
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<uint32_t> ids;
+    for (auto& [z, job, index] : keyed) ids.push_back(CommandId(job, index));
+    return ids;
+}
+
+static std::vector<uint32_t> Ids(const std::vector<OverlayPrimitive>& frame) {
+    std::vector<uint32_t> ids;
+    for (const OverlayPrimitive& primitive : frame) ids.push_back(primitive.id);
+    return ids;
+}
+
+TEST(MergeOrderIsTheSameForAnyThreadCount) {
+    for (uint32_t seed = 1; seed <= 6; ++seed) {
+        std::vector<JobPlan> plans = MakePlans(seed, 3 + seed * 5, seed % 2 ? 4 : 50);
+        std::vector<uint32_t> expected = ExpectedOrder(plans);
+
+        for (unsigned threads : { 1u, 2u, 3u, 8u }) {
+            ParallelRecorder recorder(threads);
+            AddPlans(recorder, plans);
+            CHECK(recorder.GetThreadCount() == threads);
+
+            // Repeated frames reuse the lists and workers
+            std::vector<OverlayPrimitive> frame;
+            for (int repeat = 0; repeat < 5; ++repeat) {
+                recorder.Record(1920, 1080, frame);
+                CHECK(Ids(frame) == expected);
+            }
+        }
+    }
+}
+
+TEST(SingleKeyConcatenatesInJobOrder) {
+    std::vector<JobPlan> plans = MakePlans(9, 12, 1);
+    for (JobPlan& plan : plans) {
+        plan.initialZ = 3;
+        std::fill(plan.keys.begin(), plan.keys.end(), -1000);
+    }
+
+    ParallelRecorder recorder(4);
+    AddPlans(recorder, plans);
+    std::vector<OverlayPrimitive> frame;
+    recorder.Record(100, 100, frame);
+    CHECK(Ids(frame) == ExpectedOrder(plans));
+}
+
+TEST(EmptyAndMissingJobs) {
+    ParallelRecorder recorder(4);
+    std::vector<OverlayPrimitive> frame(3);
+    recorder.Record(10, 10, frame);
+    CHECK(frame.empty());
+
+    recorder.AddJob(nullptr, 5);
+    recorder.AddJob([](CommandList&, int, int) {});
+    recorder.AddJob([](CommandList& list, int, int) { list.DrawLine(0, 0, 1, 1, 1, 0).id = 42; }, 2);
+    CHECK(recorder.GetJobCount() == 3);
+
+    recorder.Record(10, 10, frame);
+    REQUIRE(frame.size() == 1);
+    CHECK(frame[0].id == 42);
+
+    recorder.ClearJobs();
+    recorder.Record(10, 10, frame);
+    CHECK(frame.empty());
+}
+
+TEST(JobsSeeTheFrameSize) {
+    ParallelRecorder recorder(3);
+    for (int job = 0; job < 6; ++job) {
+        recorder.AddJob([](CommandList& list, int width, int height) {
+            list.DrawSolidRectangle(0.0f, 0.0f, (float)width, (float)height, 0);
+        });
+    }
+
+    std::vector<OverlayPrimitive> frame;
+    recorder.Record(640, 360, frame);
+    REQUIRE(frame.size() == 6);
+    for (const OverlayPrimitive& primitive : frame) CHECK(primitive.x1 == 640.0f && primitive.y1 == 360.0f);
+}
+
+TEST(SortByZIsStable) {
+    CommandList list;
+    const int32_t keys[] = { 2, 0, 2, 1, 0, 2, -1 };
+    for (uint32_t i = 0; i < 7; ++i) {
+        list.SetZ(keys[i]);
+        list.DrawLine(0, 0, 0, 0, 1, 0).id = i;
+    }
+
+    list.SortByZ();
+    const uint32_t expected[] = { 6, 1, 4, 3, 0, 2, 5 };
+    for (size_t i = 0; i < 7; ++i) {
+        CHECK(list.GetCommand(i).id == expected[i]);
+        CHECK(list.GetCommandZ(i) == keys[expected[i]]);
+    }
+}
+
+TEST(ClearKeepsStorageButResetsCommands) {
+    CommandList list;
+    list.SetZ(4);
+    list.DrawTextWithOutline(L"first", 1, 2, 12, 0xFFu).flags = 1;
+    list.Clear();
+    CHECK(list.GetCount() == 0);
+    CHECK(list.GetZ() == 0);
+
+    // Reused slots do not leak text, ids or flags from the previous frame
+    OverlayPrimitive& circle = list.DrawSolidCircle(5, 6, 7, 0x11223344u);
+    CHECK(circle.text.empty() && circle.id == 0 && circle.flags == 0);
+    CHECK(circle.type == (uint16_t)SceneElementType::SolidCircle);
+    CHECK(list.GetCommandZ(0) == 0);
+
+    OverlayPrimitive& text = list.DrawTextWithOutline(nullptr, 0, 0, 12, 0);
+    CHECK(text.text.empty());
+}
+
+TEST(RgbaPacksAndClamps) {
+    CHECK(CommandList::Rgba(1.0f, 0.0f, 0.0f) == 0xFF0000FFu);
+    CHECK(CommandList::Rgba(0.0f, 1.0f, 0.0f, 0.5f) == 0x00FF0080u);
+    CHECK(CommandList::Rgba(-1.0f, 2.0f, 0.2f, 0.0f) == 0x00FF3300u);
+}
+
+int main() {
+    return RunTests();
+}
@@ -0,0 +1,295 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "FrameDelta.hpp"
+#include "TestHarness.hpp"
+
+// What the decoder should hold for a frame: coordinates quantized, text made representable
+static std::vector<OverlayPrimitive> Reconstructed(std::vector<OverlayPrimitive> frame) {
+    for (OverlayPrimitive& primitive : frame) {
+        for (uint32_t field = 0; field < kDeltaCoordinateCount; ++field) {
+            float* coordinate = FrameDelta::Coordinate(primitive, field);
+            *coordinate = FrameDelta::Dequantize(FrameDelta::Quantize(*coordinate));
+        }
+        FrameDelta::SanitizeText(primitive.text);
+    }
+    return frame;
+}
+
+static bool SamePrimitives(const std::vector<OverlayPrimitive>& a, const std::vector<OverlayPrimitive>& b) {
+    if (a.size() != b.size()) return false;
+
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].id != b[i].id || a[i].type != b[i].type || a[i].flags != b[i].flags || a[i].color != b[i].color) return false;
+        if (a[i].text != b[i].text) return false;
+        for (uint32_t field = 0; field < kDeltaCoordinateCount; ++field) {
+            if (FrameDelta::GetCoordinate(a[i], field) != FrameDelta::GetCoordinate(b[i], field)) return false;
+        }
+    }
+    return true;
+}
+
+static bool RoundTrip(FrameDeltaEncoder& encoder, FrameDeltaDecoder& decoder, const std::vector<OverlayPrimitive>& frame, size_t* bytes = nullptr) {
+    std::vector<uint8_t> encoded;
+    encoder.Encode(frame, encoded);
+    if (bytes) *bytes = encoded.size();
+
+    return decoder.Decode(encoded.data(), encoded.size()) && SamePrimitives(decoder.GetFrame(), Reconstructed(frame));
+}
+
+static OverlayPrimitive Marker(uint32_t id, float x, float y) {
+    OverlayPrimitive primitive;
+    primitive.id = id;
+    primitive.type = (uint16_t)SceneElementType::HollowCircle;
+    primitive.color = 0xFF8000FFu;
+    primitive.x0 = x;
+    primitive.y0 = y;
+    primitive.size = 6.0f;
+    primitive.stroke = 1.5f;
+    return primitive;
+}
+
+TEST(RandomFramesRoundTrip) {
+    std::mt19937 random(21);
+    std::uniform_real_distribution<float> position(-50.0f, 2000.0f);
+    std::normal_distribution<float> jitter(0.0f, 1.5f);
+
+    FrameDeltaEncoder encoder(30);
+    FrameDeltaDecoder decoder;
+    std::vector<OverlayPrimitive> frame;
+    uint32_t nextId = 1;
+
+    for (int f = 0; f < 300; ++f) {
+        int change = (int)(random() % 8);
+        if (change == 0) {
+            // New primitives at random places
+            for (int i = 0; i < 5; ++i) {
+                size_t at = frame.empty() ? 0 : random() % (frame.size() + 1);
+                frame.insert(frame.begin() + at, Marker(nextId++, position(random), position(random)));
+            }
+        }
+        else if (change == 1 && frame.size() > 10) {
+            for (int i = 0; i < 3; ++i) frame.erase(frame.begin() + random() % frame.size());
+        }
+        else if (change == 2 && frame.size() > 2) {
+            std::swap(frame[random() % frame.size()], frame[random() % frame.size()]);
+        }
+        else if (change == 3 && !frame.empty()) {
+            OverlayPrimitive& label = frame[random() % frame.size()];
+            label.type = (uint16_t)SceneElementType::Text;
+            label.text = L"fps " + std::to_wstring(f);
+        }
+        else if (change == 4 && !frame.empty()) {
+            frame[random() % frame.size()].color ^= 0x00FF0000u;
+        }
+
+        for (OverlayPrimitive& primitive : frame) {
+            if (random() % 3 == 0) {
+                primitive.x0 += jitter(random);
+                primitive.y0 += jitter(random);
+            }
+        }
+
+        if (f == 150) encoder.ForceKeyframe();
+        CHECK(RoundTrip(encoder, decoder, frame));
+    }
+}
+
+TEST(UnchangedFramesCostAFewBytes) {
+    std::vector<OverlayPrimitive> frame;
+    for (uint32_t i = 0; i < 1000; ++i) frame.push_back(Marker(i, i * 1.7f, i * 0.9f));
+
+    FrameDeltaEncoder encoder;
+    FrameDeltaDecoder decoder;
+    size_t keyframeBytes, deltaBytes;
+    CHECK(RoundTrip(encoder, decoder, frame, &keyframeBytes));
+    CHECK(RoundTrip(encoder, decoder, frame, &deltaBytes));
+
+    // Flags, count and one run
+    CHECK(deltaBytes == 5);
+    CHECK(keyframeBytes > 10000);
+
+    // One moved marker costs a run, its fields and another run
+    frame[500].x0 += 1.0f;
+    CHECK(RoundTrip(encoder, decoder, frame, &deltaBytes));
+    CHECK(deltaBytes <= 12);
+}
+
+TEST(KeyframeInterval) {
+    std::vector<OverlayPrimitive> frame = { Marker(1, 10.0f, 10.0f) };
+    FrameDeltaEncoder encoder(3);
+    std::vector<uint8_t> out;
+
+    bool expected[] = { true, false, false, true, false, false, true };
+    for (bool keyframe : expected) CHECK(encoder.Encode(frame, out) == keyframe);
+
+    encoder.ForceKeyframe();
+    CHECK(encoder.Encode(frame, out));
+    CHECK(!encoder.Encode(frame, out));
+}
+
+TEST(DeltaFramesNeedAKeyframe) {
+    std::vector<OverlayPrimitive> frame = { Marker(1, 10.0f, 10.0f), Marker(2, 20.0f, 20.0f) };
+    FrameDeltaEncoder encoder;
+    std::vector<uint8_t> keyframe, delta;
+    encoder.Encode(frame, keyframe);
+    frame[1].x0 = 25.0f;
+    encoder.Encode(frame, delta);
+
+    FrameDeltaDecoder decoder;
+    CHECK(!decoder.Decode(delta.data(), delta.size()));
+    CHECK(decoder.Decode(keyframe.data(), keyframe.size()));
+    CHECK(decoder.Decode(delta.data(), delta.size()));
+    CHECK(decoder.GetFrame()[1].x0 == 25.0f);
+
+    decoder.Reset();
+    CHECK(!decoder.IsValid());
+    CHECK(!decoder.Decode(delta.data(), delta.size()));
+}
+
+TEST(TruncatedFramesAreRejected) {
+    std::vector<OverlayPrimitive> frame = { Marker(1, 10.0f, 10.0f), Marker(7, 20.0f, 20.0f) };
+    frame[1].text = L"label";
+
+    FrameDeltaEncoder encoder;
+    std::vector<uint8_t> encoded;
+    encoder.Encode(frame, encoded);
+
+    FrameDeltaDecoder decoder;
+    for (size_t size = 0; size < encoded.size(); ++size) CHECK(!decoder.Decode(encoded.data(), size));
+
+    // Trailing bytes are malformed too
+    encoded.push_back(0);
+    CHECK(!decoder.Decode(encoded.data(), encoded.size()));
+    CHECK(decoder.Decode(encoded.data(), encoded.size() - 1));
+}
+
+TEST(TextIsUtf16OnTheWire) {
+    std::u16string units;
+    FrameDelta::ToUtf16(L"a\U0001F600b", units);
+    CHECK(units == u"a\U0001F600b");
+    CHECK(units.size() == 4);
+
+    std::wstring text;
+    FrameDelta::FromUtf16(units, text);
+    CHECK(text == L"a\U0001F600b");
+
+    std::vector<OverlayPrimitive> frame = { Marker(1, 0.0f, 0.0f) };
+    frame[0].type = (uint16_t)SceneElementType::Text;
+    frame[0].text = L"\u00E9t\u00E9 \U0001F600 \U00010348";
+
+    FrameDeltaEncoder encoder;
+    FrameDeltaDecoder decoder;
+    CHECK(RoundTrip(encoder, decoder, frame));
+    CHECK(decoder.GetFrame()[0].text == frame[0].text);
+}
+
+TEST(UnrepresentableTextBecomesReplacementCharacters) {
+    if constexpr (sizeof(wchar_t) > 2) {
+        std::wstring text = L"x";
+        text.push_back((wchar_t)0x110000);
+        text.push_back((wchar_t)0xD800);
+
+        std::vector<OverlayPrimitive> frame = { Marker(1, 0.0f, 0.0f) };
+        frame[0].text = text;
+
+        FrameDeltaEncoder encoder;
+        FrameDeltaDecoder decoder;
+        CHECK(RoundTrip(encoder, decoder, frame));
+        CHECK(decoder.GetFrame()[0].text == L"x\uFFFD\uFFFD");
+
+        // The replaced text counts as unchanged on the next frame
+        size_t bytes;
+        CHECK(RoundTrip(encoder, decoder, frame, &bytes));
+        CHECK(bytes == 3);
+    }
+
+    // Lone surrogates on the wire
+    std::wstring text;
+    FrameDelta::FromUtf16(u"\xDC00" u"a" u"\xD800", text);
+    if constexpr (sizeof(wchar_t) > 2) CHECK(text == L"\uFFFDa\uFFFD");
+    else CHECK(text.size() == 3 && text[1] == L'a');
+}
+
+TEST(CodeUnitsAboveFFFFAreMalformed) {
+    // Keyframe, one primitive, mask = explicit id | text, id 0, one unit
+    auto frame = [](uint64_t unit) {
+        std::vector<uint8_t> bytes;
+        FrameDelta::PutVarint(bytes, kDeltaKeyframe);
+        FrameDelta::PutVarint(bytes, 1);
+        FrameDelta::PutVarint(bytes, (uint64_t)(kDeltaExplicitId | kDeltaText) << 1);
+        FrameDelta::PutVarint(bytes, FrameDelta::ZigZag(0));
+        FrameDelta::PutVarint(bytes, 1);
+        FrameDelta::PutVarint(bytes, unit);
+        return bytes;
+    };
+
+    FrameDeltaDecoder decoder;
+    std::vector<uint8_t> valid = frame(0x41);
+    REQUIRE(decoder.Decode(valid.data(), valid.size()));
+    CHECK(decoder.GetFrame()[0].text == L"A");
+
+    std::vector<uint8_t> invalid = frame(0x10000);
+    CHECK(!decoder.Decode(invalid.data(), invalid.size()));
+}
+
+TEST(QuantizeClampsNonFiniteAndHugeValues) {
+    float nan = std::numeric_limits<float>::quiet_NaN();
+    float inf = std::numeric_limits<float>::infinity();
+
+    CHECK(FrameDelta::Quantize(nan) == 0);
+    CHECK(FrameDelta::Quantize(inf) == kDeltaQuantizedLimit);
+    CHECK(FrameDelta::Quantize(-inf) == -kDeltaQuantizedLimit);
+    CHECK(FrameDelta::Quantize(1e30f) == kDeltaQuantizedLimit);
+    CHECK(FrameDelta::Quantize(-3e9f) == -kDeltaQuantizedLimit);
+    CHECK(FrameDelta::Quantize(1.26f) == 10);
+    CHECK(FrameDelta::Quantize(-1.26f) == -10);
+
+    // Extremes in both directions between frames stay within the delta range
+    std::vector<OverlayPrimitive> frame = { Marker(1, nan, 1e30f) };
+    frame[0].x1 = -inf;
+    frame[0].y1 = inf;
+
+    FrameDeltaEncoder encoder;
+    FrameDeltaDecoder decoder;
+    CHECK(RoundTrip(encoder, decoder, frame));
+    CHECK(decoder.GetFrame()[0].x0 == 0.0f);
+
+    frame[0].x1 = inf;
+    frame[0].y1 = -inf;
+    CHECK(RoundTrip(encoder, decoder, frame));
+    frame[0].x1 = 5.0f;
+    CHECK(RoundTrip(encoder, decoder, frame));
+}
+
+TEST(CoordinatesOutsideTheRangeAreMalformed) {
+    auto frame = [](int64_t delta) {
+        std::vector<uint8_t> bytes;
+        FrameDelta::PutVarint(bytes, kDeltaKeyframe);
+        FrameDelta::PutVarint(bytes, 1);
+        FrameDelta::PutVarint(bytes, (uint64_t)(kDeltaExplicitId | kDeltaX0) << 1);
+        FrameDelta::PutVarint(bytes, FrameDelta::ZigZag(0));
+        FrameDelta::PutVarint(bytes, FrameDelta::ZigZag(delta));
+        return bytes;
+    };
+
+    FrameDeltaDecoder decoder;
+    for (int64_t delta : { (int64_t)kDeltaQuantizedLimit, -(int64_t)kDeltaQuantizedLimit, (int64_t)-8 }) {
+        std::vector<uint8_t> bytes = frame(delta);
+        CHECK(decoder.Decode(bytes.data(), bytes.size()));
+    }
+    CHECK(decoder.GetFrame()[0].x0 == -1.0f);
+
+    for (int64_t delta : { (int64_t)kDeltaQuantizedLimit + 1, (int64_t)1 << 40, (std::numeric_limits<int64_t>::min)() }) {
+        std::vector<uint8_t> bytes = frame(delta);
+        CHECK(!decoder.Decode(bytes.data(), bytes.size()));
+    }
+}
+
+int main() {
+    return RunTests();
+}
@@ -0,0 +1,178 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameScheduler.hpp"
+#include "TestHarness.hpp"
+
+using namespace std::chrono_literals;
+
+// Runs frames until done() or the timeout; returns false on timeout
+template <typename Done>
+static bool RunUntil(FrameScheduler& scheduler, Done done, std::chrono::seconds timeout = 10s) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        scheduler.RunFrame(1000);
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+static FrameTask HopToWorker(FrameScheduler& scheduler, std::atomic<int>& done) {
+    co_await scheduler.OnWorker();
+    done++;
+}
+
+TEST(ManyTasksFinishOnWorkers) {
+    FrameScheduler scheduler(4);
+    std::atomic<int> done(0);
+
+    for (int i = 0; i < 2000; ++i) scheduler.Spawn(HopToWorker(scheduler, done));
+    CHECK(scheduler.GetLiveTaskCount() == 2000);
+
+    CHECK(RunUntil(scheduler, [&] { return scheduler.GetLiveTaskCount() == 0; }));
+    CHECK(done == 2000);
+}
+
+static FrameTask PingPong(FrameScheduler& scheduler, std::thread::id renderThread, int hops, std::atomic<int>& done,
+    std::atomic<int>& wrongThread) {
+    for (int i = 0; i < hops; ++i) {
+        co_await scheduler.OnWorker();
+        if (std::this_thread::get_id() == renderThread) wrongThread++;
+
+        co_await scheduler.NextFrame();
+        if (std::this_thread::get_id() != renderThread) wrongThread++;
+    }
+    done++;
+}
+
+TEST(TasksMoveBetweenWorkersAndFrames) {
+    FrameScheduler scheduler(4);
+    std::atomic<int> done(0), wrongThread(0);
+
+    for (int i = 0; i < 200; ++i) scheduler.Spawn(PingPong(scheduler, std::this_thread::get_id(), 5, done, wrongThread));
+
+    CHECK(RunUntil(scheduler, [&] { return scheduler.GetLiveTaskCount() == 0; }));
+    CHECK(done == 200);
+    CHECK(wrongThread == 0);
+}
+
+static FrameTask Record(FrameScheduler& scheduler, std::vector<std::string>& log, std::string name, int frames) {
+    for (int i = 0; i < frames; ++i) {
+        log.push_back(name + std::to_string(i));
+        co_await scheduler.NextFrame();
+    }
+}
+
+TEST(FrameTasksRunInSpawnOrderOncePerFrame) {
+    FrameScheduler scheduler(0);
+    std::vector<std::string> log;
+    scheduler.Spawn(Record(scheduler, log, "a", 2));
+    scheduler.Spawn(Record(scheduler, log, "b", 2));
+
+    // Nothing runs before the first frame
+    CHECK(log.empty());
+
+    scheduler.RunFrame(100000);
+    CHECK((log == std::vector<std::string>{ "a0", "b0" }));
+
+    scheduler.RunFrame(100000);
+    CHECK((log == std::vector<std::string>{ "a0", "b0", "a1", "b1" }));
+
+    scheduler.RunFrame(100000);
+    CHECK(scheduler.GetLiveTaskCount() == 0);
+    CHECK(scheduler.GetFrameIndex() == 3);
+}
+
+static FrameTask Sleeper(std::atomic<int>& ran) {
+    std::this_thread::sleep_for(2ms);
+    ran++;
+    co_return;
+}
+
+TEST(SliceCarriesWorkOver) {
+    FrameScheduler scheduler(0);
+    std::atomic<int> ran(0);
+    for (int i = 0; i < 10; ++i) scheduler.Spawn(Sleeper(ran));
+
+    // A zero slice still runs one task per frame
+    scheduler.RunFrame(0);
+    CHECK(ran == 1);
+
+    scheduler.RunFrame(3000);
+    CHECK(ran >= 2 && ran < 10);
+
+    CHECK(RunUntil(scheduler, [&] { return ran == 10; }));
+    CHECK(scheduler.GetLiveTaskCount() == 0);
+}
+
+static FrameTask Budgeted(FrameScheduler& scheduler, int items, std::atomic<int>& processed, std::vector<uint64_t>& frames) {
+    for (int i = 0; i < items; ++i) {
+        std::this_thread::sleep_for(200us);
+        processed++;
+        if (frames.empty() || frames.back() != scheduler.GetFrameIndex()) frames.push_back(scheduler.GetFrameIndex());
+        co_await scheduler.BudgetRemaining();
+    }
+}
+
+TEST(BudgetRemainingYieldsOnlyWhenOutOfTime) {
+    FrameScheduler scheduler(0);
+    std::atomic<int> processed(0);
+    std::vector<uint64_t> frames;
+    scheduler.Spawn(Budgeted(scheduler, 50, processed, frames));
+
+    CHECK(RunUntil(scheduler, [&] { return scheduler.GetLiveTaskCount() == 0; }));
+    CHECK(processed == 50);
+
+    // 10 ms of work in 1 ms slices spans several frames, but far fewer than one per item
+    CHECK(frames.size() > 1 && frames.size() < 50);
+
+    // Off the render thread there is no slice
+    CHECK(scheduler.RemainingUs() == 0);
+}
+
+TEST(OnWorkerWithoutWorkersContinuesInline) {
+    FrameScheduler scheduler(0);
+    std::atomic<int> done(0);
+    scheduler.Spawn(HopToWorker(scheduler, done));
+
+    scheduler.RunFrame(1000);
+    CHECK(done == 1);
+    CHECK(scheduler.GetLiveTaskCount() == 0);
+}
+
+struct DestroyCounter {
+    std::atomic<int>* count;
+    ~DestroyCounter() { (*count)++; }
+};
+
+static FrameTask Forever(FrameScheduler& scheduler, std::atomic<int>& destroyed) {
+    DestroyCounter counter{ &destroyed };
+    for (;;) co_await scheduler.NextFrame();
+}
+
+TEST(UnfinishedTasksAreDestroyedWithTheScheduler) {
+    std::atomic<int> destroyed(0);
+    {
+        FrameScheduler scheduler(2);
+        for (int i = 0; i < 5; ++i) scheduler.Spawn(Forever(scheduler, destroyed));
+        scheduler.RunFrame(1000);
+        scheduler.RunFrame(1000);
+        CHECK(destroyed == 0);
+    }
+    CHECK(destroyed == 5);
+
+    // Tasks never spawned are destroyed by their FrameTask
+    {
+        FrameScheduler scheduler(0);
+        FrameTask task = Forever(scheduler, destroyed);
+    }
+    CHECK(destroyed == 5);
+}
+
+int main() {
+    return RunTests();
+}
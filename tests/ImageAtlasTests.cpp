@@ -0,0 +1,330 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "ImageAtlas.hpp"
+#include "TestHarness.hpp"
+
+static std::vector<uint32_t> RandomImage(std::mt19937& random, int width, int height) {
+    std::vector<uint32_t> pixels((size_t)width * height);
+    for (uint32_t& pixel : pixels) pixel = random();
+    return pixels;
+}
+
+// Premultiplied pixel: no channel above alpha
+static uint32_t RandomPremultiplied(std::mt19937& random) {
+    uint32_t alpha = random() % 256;
+    uint32_t pixel = alpha << 24;
+    for (int shift = 0; shift < 24; shift += 8) pixel |= (alpha ? random() % (alpha + 1) : 0) << shift;
+    return pixel;
+}
+
+static uint32_t Pixel(const ImageAtlas& atlas, int x, int y) {
+    return atlas.GetPixels()[(size_t)y * atlas.GetWidth() + x];
+}
+
+static bool Overlap(const StampRect& a, const StampRect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static StampRect WithBorder(const StampRect& rect) {
+    return { rect.x - 1, rect.y - 1, rect.width + 2, rect.height + 2 };
+}
+
+TEST(LevelsArePackedWithoutOverlap) {
+    std::mt19937 random(31);
+    ImageAtlas atlas(512, 512);
+    std::vector<StampRect> placed;
+
+    for (int i = 0; i < 40; ++i) {
+        int width = 1 + (int)(random() % 48), height = 1 + (int)(random() % 48);
+        std::vector<uint32_t> pixels = RandomImage(random, width, height);
+        ImageId id = atlas.AddImage(pixels.data(), width, height, width * sizeof(uint32_t));
+        REQUIRE(id != kInvalidImage);
+
+        for (int level = 0; level < atlas.GetLevelCount(id); ++level) {
+            StampRect rect;
+            REQUIRE(atlas.GetLevel(id, level, &rect));
+            StampRect bordered = WithBorder(rect);
+            CHECK(bordered.x >= 0 && bordered.y >= 0 && bordered.x + bordered.width <= 512 && bordered.y + bordered.height <= 512);
+            for (const StampRect& other : placed) CHECK(!Overlap(bordered, other));
+            placed.push_back(bordered);
+        }
+    }
+    CHECK(atlas.GetImageCount() == 40);
+}
+
+TEST(FullAtlasLeavesNoPartialImage) {
+    std::mt19937 random(32);
+    ImageAtlas atlas(256, 128);
+    std::vector<uint32_t> pixels = RandomImage(random, 100, 100);
+
+    // The first chain fills one shelf; the second no longer fits
+    REQUIRE(atlas.AddImage(pixels.data(), 100, 100, 400) == 0);
+    CHECK(atlas.AddImage(pixels.data(), 100, 100, 400) == kInvalidImage);
+    CHECK(atlas.GetImageCount() == 1);
+    CHECK(atlas.GetLevelCount(1) == 0);
+
+    // A later image still gets its own levels
+    ImageId small = atlas.AddImage(pixels.data(), 10, 10, 400);
+    REQUIRE(small == 1);
+    CHECK(atlas.GetLevelCount(small) == 4);
+    StampRect first, second;
+    REQUIRE(atlas.GetLevel(0, 0, &first));
+    REQUIRE(atlas.GetLevel(small, 0, &second));
+    CHECK(second.width == 10 && !Overlap(WithBorder(first), WithBorder(second)));
+
+    // Too large or invalid input
+    CHECK(atlas.AddImage(pixels.data(), ImageAtlas::kMaxImageSize + 1, 1, 400) == kInvalidImage);
+    CHECK(atlas.AddImage(nullptr, 4, 4, 16) == kInvalidImage);
+    CHECK(atlas.AddImage(pixels.data(), 0, 4, 16) == kInvalidImage);
+
+    uint32_t generation = atlas.GetGeneration();
+    atlas.Clear();
+    CHECK(atlas.GetGeneration() == generation + 1);
+    CHECK(atlas.GetImageCount() == 0);
+    CHECK(atlas.AddImage(pixels.data(), 100, 100, 400) == 0);
+}
+
+TEST(MipChainsHalveDownToOnePixel) {
+    std::mt19937 random(33);
+    ImageAtlas atlas;
+    std::vector<uint32_t> pixels = RandomImage(random, 37, 5);
+    ImageId id = atlas.AddImage(pixels.data(), 37, 5, 37 * sizeof(uint32_t));
+
+    const int widths[] = { 37, 18, 9, 4, 2, 1 };
+    const int heights[] = { 5, 2, 1, 1, 1, 1 };
+    REQUIRE(atlas.GetLevelCount(id) == 6);
+    for (int level = 0; level < 6; ++level) {
+        StampRect rect;
+        REQUIRE(atlas.GetLevel(id, level, &rect));
+        CHECK(rect.width == widths[level] && rect.height == heights[level]);
+    }
+    CHECK(!atlas.GetLevel(id, 6, nullptr));
+}
+
+// Source pixels and weights (adding up to 4) behind output x on one axis of a downsample
+static void DownsampleTaps(int x, int sourceSize, int targetSize, int indices[3], int weights[3]) {
+    indices[0] = (std::min)(x * 2, sourceSize - 1);
+    indices[1] = (std::min)(x * 2 + 1, sourceSize - 1);
+    indices[2] = (std::min)(x * 2 + 2, sourceSize - 1);
+    bool odd = x == targetSize - 1 && x * 2 + 2 < sourceSize;
+    weights[0] = odd ? 1 : 2;
+    weights[1] = 2;
+    weights[2] = odd ? 1 : 0;
+}
+
+TEST(MipLevelsAreRoundedBoxAverages) {
+    std::mt19937 random(34);
+    ImageAtlas atlas;
+    std::vector<uint32_t> pixels(45 * 23);
+    for (uint32_t& pixel : pixels) pixel = RandomPremultiplied(random);
+    ImageId id = atlas.AddImage(pixels.data(), 45, 23, 45 * sizeof(uint32_t), true);
+
+    for (int level = 1; level < atlas.GetLevelCount(id); ++level) {
+        StampRect above = {}, current = {};
+        REQUIRE(atlas.GetLevel(id, level - 1, &above));
+        REQUIRE(atlas.GetLevel(id, level, &current));
+
+        for (int y = 0; y < current.height; ++y) {
+            for (int x = 0; x < current.width; ++x) {
+                int columns[3], columnWeights[3], rows[3], rowWeights[3];
+                DownsampleTaps(x, above.width, current.width, columns, columnWeights);
+                DownsampleTaps(y, above.height, current.height, rows, rowWeights);
+
+                uint32_t expected = 0;
+                for (int shift = 0; shift < 32; shift += 8) {
+                    uint32_t sum = 0;
+                    for (int i = 0; i < 3; ++i) {
+                        for (int j = 0; j < 3; ++j) {
+                            uint32_t pixel = Pixel(atlas, above.x + columns[j], above.y + rows[i]);
+                            sum += ((pixel >> shift) & 255) * (uint32_t)(rowWeights[i] * columnWeights[j]);
+                        }
+                    }
+                    expected |= ((sum + 8) >> 4) << shift;
+                }
+                CHECK(Pixel(atlas, current.x + x, current.y + y) == expected);
+            }
+        }
+    }
+}
+
+TEST(OddEdgesReachLowerLevels) {
+    // A bright last column and last row on an odd-sized black image
+    const int width = 41, height = 21;
+    ImageAtlas atlas;
+    std::vector<uint32_t> pixels(width * height, 0xFF000000u);
+    for (int y = 0; y < height; ++y) pixels[y * width + width - 1] = 0xFFFFFFFFu;
+    for (int x = 0; x < width; ++x) pixels[(height - 1) * width + x] = 0xFFFFFFFFu;
+    ImageId id = atlas.AddImage(pixels.data(), width, height, width * sizeof(uint32_t), true);
+
+    // Every level that still has an odd parent keeps some of the edge in its last column and row
+    for (int level = 1; level < atlas.GetLevelCount(id); ++level) {
+        StampRect above = {}, current = {};
+        REQUIRE(atlas.GetLevel(id, level - 1, &above));
+        REQUIRE(atlas.GetLevel(id, level, &current));
+
+        if (above.width > 1 && (above.width & 1)) {
+            CHECK((Pixel(atlas, current.x + current.width - 1, current.y) & 0xFF) > 0);
+        }
+        if (above.height > 1 && (above.height & 1)) {
+            CHECK((Pixel(atlas, current.x, current.y + current.height - 1) & 0xFF) > 0);
+        }
+    }
+
+    // 41x21 -> 20x10: the last column weighs source columns 38-40 as 1-2-1
+    StampRect half = {};
+    REQUIRE(atlas.GetLevel(id, 1, &half));
+    CHECK(Pixel(atlas, half.x + half.width - 1, half.y) == 0xFF404040u);
+    CHECK(Pixel(atlas, half.x, half.y + half.height - 1) == 0xFF404040u);
+    CHECK(Pixel(atlas, half.x + half.width - 2, half.y) == 0xFF000000u);
+}
+
+TEST(BordersRepeatEdgePixels) {
+    std::mt19937 random(35);
+    ImageAtlas atlas;
+    std::vector<uint32_t> pixels = RandomImage(random, 9, 6);
+    ImageId id = atlas.AddImage(pixels.data(), 9, 6, 9 * sizeof(uint32_t));
+
+    for (int level = 0; level < atlas.GetLevelCount(id); ++level) {
+        StampRect rect;
+        atlas.GetLevel(id, level, &rect);
+        for (int y = -1; y <= rect.height; ++y) {
+            for (int x = -1; x <= rect.width; ++x) {
+                int cx = (std::min)((std::max)(x, 0), rect.width - 1), cy = (std::min)((std::max)(y, 0), rect.height - 1);
+                CHECK(Pixel(atlas, rect.x + x, rect.y + y) == Pixel(atlas, rect.x + cx, rect.y + cy));
+            }
+        }
+    }
+}
+
+TEST(StraightAlphaIsPremultiplied) {
+    CHECK(ImageAtlas::Premultiply(0xFF123456u) == 0xFF123456u);
+    CHECK(ImageAtlas::Premultiply(0x00FFFFFFu) == 0x00000000u);
+    CHECK(ImageAtlas::Premultiply(0x80FF8000u) == 0x80804000u);
+
+    ImageAtlas atlas;
+    uint32_t pixel = 0x80FF8000u;
+    ImageId id = atlas.AddImage(&pixel, 1, 1, 4);
+    StampRect rect;
+    atlas.GetLevel(id, 0, &rect);
+    CHECK(Pixel(atlas, rect.x, rect.y) == 0x80804000u);
+}
+
+TEST(SelectLevelUsesRealLevelSizes) {
+    std::mt19937 random(36);
+    ImageAtlas atlas;
+    std::vector<uint32_t> pixels = RandomImage(random, 5, 5);
+    ImageId id = atlas.AddImage(pixels.data(), 5, 5, 5 * sizeof(uint32_t));
+
+    // Levels are 5, 2 and 1 pixels: a 2.5 px destination needs level 0, not the 2 px level
+    CHECK(atlas.SelectLevel(id, 2.5f, 2.5f) == 0);
+    CHECK(atlas.SelectLevel(id, 2.0f, 2.0f) == 1);
+    CHECK(atlas.SelectLevel(id, 1.5f, 1.5f) == 1);
+    CHECK(atlas.SelectLevel(id, 1.0f, 1.0f) == 2);
+    CHECK(atlas.SelectLevel(id, 0.1f, 0.1f) == 2);
+    CHECK(atlas.SelectLevel(id, 50.0f, 50.0f) == 0);
+
+    // Both axes must be covered
+    std::vector<uint32_t> wide = RandomImage(random, 64, 16);
+    ImageId wideId = atlas.AddImage(wide.data(), 64, 16, 64 * sizeof(uint32_t));
+    CHECK(atlas.SelectLevel(wideId, 16.0f, 16.0f) == 0);
+    CHECK(atlas.SelectLevel(wideId, 16.0f, 4.0f) == 2);
+    CHECK(atlas.SelectLevel(wideId, 32.0f, 1.0f) == 1);
+
+    CHECK(atlas.SelectLevel(id, 0.0f, 1.0f) == 0);
+    CHECK(atlas.SelectLevel(kInvalidImage, 1.0f, 1.0f) == 0);
+}
+
+TEST(BlendMatchesScalarBitForBit) {
+    std::mt19937 random(37);
+    for (int i = 0; i < 200000; ++i) {
+        uint32_t dest = RandomPremultiplied(random);
+        uint32_t p00 = RandomPremultiplied(random), p10 = RandomPremultiplied(random);
+        uint32_t p01 = RandomPremultiplied(random), p11 = RandomPremultiplied(random);
+        uint32_t fx = random() % 257, fy = random() % 257;
+        uint32_t opacity = i % 4 == 0 ? 256 : random() % 257;
+
+        CHECK(BlendBilinear(dest, p00, p10, p01, p11, fx, fy, opacity) == BlendBilinearScalar(dest, p00, p10, p01, p11, fx, fy, opacity));
+    }
+
+    // Edge weights and fully opaque or transparent pixels
+    const uint32_t pixels[] = { 0x00000000u, 0xFFFFFFFFu, 0xFF000000u, 0x80404040u, 0x01010101u };
+    const uint32_t weights[] = { 0, 1, 128, 255, 256 };
+    for (uint32_t dest : pixels) {
+        for (uint32_t source : pixels) {
+            for (uint32_t fx : weights) {
+                for (uint32_t opacity : weights) {
+                    CHECK(BlendBilinear(dest, source, dest, 0xFFFFFFFFu, source, fx, 256 - fx, opacity) ==
+                        BlendBilinearScalar(dest, source, dest, 0xFFFFFFFFu, source, fx, 256 - fx, opacity));
+                }
+            }
+        }
+    }
+}
+
+TEST(IdentityBlitCopiesLevelZero) {
+    std::mt19937 random(38);
+    const int width = 23, height = 17;
+    std::vector<uint32_t> pixels = RandomImage(random, width, height);
+    for (uint32_t& pixel : pixels) pixel |= 0xFF000000u;
+
+    ImageAtlas atlas;
+    ImageId id = atlas.AddImage(pixels.data(), width, height, width * sizeof(uint32_t));
+
+    // Placed at a whole-pixel offset, over any background
+    const int targetWidth = 64, targetHeight = 48;
+    std::vector<uint32_t> target((size_t)targetWidth * targetHeight, 0x80102030u);
+    BlitImage(target.data(), targetWidth, targetHeight, targetWidth * sizeof(uint32_t), atlas, id, 10.0f, 5.0f, 10.0f + width, 5.0f + height);
+
+    for (int y = 0; y < targetHeight; ++y) {
+        for (int x = 0; x < targetWidth; ++x) {
+            bool inside = x >= 10 && x < 10 + width && y >= 5 && y < 5 + height;
+            uint32_t expected = inside ? pixels[(size_t)(y - 5) * width + (x - 10)] : 0x80102030u;
+            CHECK(target[(size_t)y * targetWidth + x] == expected);
+        }
+    }
+}
+
+TEST(BlitClipsAndRespectsOpacity) {
+    ImageAtlas atlas;
+    std::vector<uint32_t> white(16 * 16, 0xFFFFFFFFu);
+    ImageId id = atlas.AddImage(white.data(), 16, 16, 16 * sizeof(uint32_t));
+
+    std::vector<uint32_t> target(8 * 8, 0);
+    BlitImage(target.data(), 8, 8, 8 * sizeof(uint32_t), atlas, id, -4.0f, -4.0f, 12.0f, 12.0f, 0.5f);
+    for (uint32_t pixel : target) CHECK(pixel == 0x7F7F7F7Fu);
+
+    // Nothing drawn for empty rectangles, zero opacity or unknown images
+    std::vector<uint32_t> untouched(8 * 8, 0);
+    BlitImage(untouched.data(), 8, 8, 32, atlas, id, 4.0f, 4.0f, 4.0f, 8.0f);
+    BlitImage(untouched.data(), 8, 8, 32, atlas, id, 0.0f, 0.0f, 8.0f, 8.0f, 0.0f);
+    BlitImage(untouched.data(), 8, 8, 32, atlas, 99, 0.0f, 0.0f, 8.0f, 8.0f);
+    BlitImage(untouched.data(), 8, 8, 32, atlas, id, 20.0f, 20.0f, 30.0f, 30.0f);
+    for (uint32_t pixel : untouched) CHECK(pixel == 0);
+}
+
+TEST(DirtyRectCoversNewImages) {
+    std::mt19937 random(39);
+    ImageAtlas atlas;
+    StampRect dirty;
+    CHECK(!atlas.GetDirtyRect(&dirty));
+
+    std::vector<uint32_t> pixels = RandomImage(random, 20, 20);
+    ImageId id = atlas.AddImage(pixels.data(), 20, 20, 80);
+    REQUIRE(atlas.GetDirtyRect(&dirty));
+    for (int level = 0; level < atlas.GetLevelCount(id); ++level) {
+        StampRect rect;
+        atlas.GetLevel(id, level, &rect);
+        StampRect bordered = WithBorder(rect);
+        CHECK(bordered.x >= dirty.x && bordered.y >= dirty.y &&
+            bordered.x + bordered.width <= dirty.x + dirty.width && bordered.y + bordered.height <= dirty.y + dirty.height);
+    }
+
+    atlas.ClearDirty();
+    CHECK(!atlas.GetDirtyRect(&dirty));
+}
+
+int main() {
+    return RunTests();
+}
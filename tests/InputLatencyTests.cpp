@@ -0,0 +1,188 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "InputLatency.hpp"
+#include "TestHarness.hpp"
+
+// Synthetic input traces: a true path sampled by a device at some report rate, read by the
+// frame loop at its own rate, then predicted a frame's latency ahead.
+
+struct Trace {
+    double (*x)(double ms);
+    double (*y)(double ms);
+};
+
+static double Distance(MotionPredictor::Point p, double x, double y) {
+    return std::sqrt((p.x - x) * (p.x - x) + (p.y - y) * (p.y - y));
+}
+
+// Mean error of the prediction (and of just using the latest sample) over a trace. The
+// device reports every reportUs; the loop samples every loopUs and predicts horizonUs ahead.
+static void RunTrace(const Trace& trace, MotionPredictor& predictor, int64_t reportUs, int64_t loopUs, int64_t horizonUs,
+    double noise, double* predictedError, double* latestError) {
+    std::mt19937 random(7);
+    std::normal_distribution<double> jitter(0.0, noise > 0.0 ? noise : 1.0);
+
+    double predicted = 0.0, latest = 0.0;
+    int measured = 0;
+    for (int64_t t = 0; t < 2000000; t += loopUs) {
+        // What the device last reported, with the time the loop read it
+        int64_t reportedUs = t / reportUs * reportUs;
+        double x = trace.x(reportedUs / 1000.0) + (noise > 0.0 ? jitter(random) : 0.0);
+        double y = trace.y(reportedUs / 1000.0) + (noise > 0.0 ? jitter(random) : 0.0);
+        predictor.AddSample(t, (float)x, (float)y);
+
+        if (t < 200000) continue;
+        double trueX = trace.x((t + horizonUs) / 1000.0);
+        double trueY = trace.y((t + horizonUs) / 1000.0);
+        predicted += Distance(predictor.Predict(t + horizonUs), trueX, trueY);
+        latest += std::sqrt((x - trueX) * (x - trueX) + (y - trueY) * (y - trueY));
+        measured++;
+    }
+
+    *predictedError = predicted / measured;
+    *latestError = latest / measured;
+}
+
+TEST(PredictsLinearMotionExactly) {
+    Trace trace = { [](double ms) { return 100.0 + 0.8 * ms; }, [](double ms) { return 50.0 - 0.3 * ms; } };
+    MotionPredictor predictor;
+    double predicted, latest;
+    RunTrace(trace, predictor, 1000, 1000, 16000, 0.0, &predicted, &latest);
+
+    CHECK(latest > 10.0);
+    CHECK(predicted < 0.5);
+}
+
+TEST(AccelerationTermFollowsCurves) {
+    Trace trace = { [](double ms) { return 500.0 + 300.0 * std::sin(ms / 300.0); }, [](double ms) { return 500.0 + 300.0 * std::cos(ms / 300.0); } };
+
+    MotionPredictor withAcceleration(50000, 50000, true);
+    MotionPredictor velocityOnly(50000, 50000, false);
+    double accelerated, linear, latest;
+    RunTrace(trace, withAcceleration, 1000, 1000, 20000, 0.0, &accelerated, &latest);
+    RunTrace(trace, velocityOnly, 1000, 1000, 20000, 0.0, &linear, &latest);
+
+    CHECK(linear < latest);
+    CHECK(accelerated < linear);
+}
+
+TEST(HandlesStaircaseFromSlowDevices) {
+    // 125 Hz mouse read by a 1 kHz loop: the position holds for 8 samples at a time
+    Trace trace = { [](double ms) { return 1.2 * ms; }, [](double ms) { return 0.4 * ms; } };
+    MotionPredictor predictor;
+    double predicted, latest;
+    RunTrace(trace, predictor, 8000, 1000, 16000, 0.0, &predicted, &latest);
+
+    CHECK(predicted < latest * 0.5);
+}
+
+TEST(NoisyInputStaysBounded) {
+    // A still cursor with sensor noise must not be thrown around by the fit
+    Trace trace = { [](double) { return 400.0; }, [](double) { return 300.0; } };
+    MotionPredictor predictor;
+    double predicted, latest;
+    RunTrace(trace, predictor, 1000, 1000, 16000, 0.5, &predicted, &latest);
+
+    CHECK(predicted < 3.0);
+}
+
+TEST(HorizonIsClamped) {
+    MotionPredictor predictor(50000, 30000);
+    for (int64_t t = 0; t <= 40000; t += 1000) predictor.AddSample(t, (float)t / 1000.0f, 0.0f);
+
+    MotionPredictor::Point clamped = predictor.Predict(40000 + 30000);
+    MotionPredictor::Point far = predictor.Predict(40000 + 1000000);
+    CHECK(std::fabs(clamped.x - far.x) < 1e-3f);
+    CHECK(std::fabs(clamped.x - 70.0f) < 0.1f);
+
+    // Targets in the past return the latest sample
+    MotionPredictor::Point past = predictor.Predict(10000);
+    CHECK(past.x == 40.0f);
+}
+
+TEST(GapsAndTimeReversalRestartHistory) {
+    MotionPredictor predictor(50000);
+    for (int64_t t = 0; t <= 20000; t += 1000) predictor.AddSample(t, (float)t, 0.0f);
+
+    // After a pause longer than the fit window the old velocity must not be reused
+    predictor.AddSample(200000, 5.0f, 5.0f);
+    MotionPredictor::Point afterGap = predictor.Predict(216000);
+    CHECK(afterGap.x == 5.0f && afterGap.y == 5.0f);
+
+    predictor.AddSample(100000, 1.0f, 2.0f);
+    CHECK(predictor.GetLatestTime() == 100000);
+    MotionPredictor::Point afterReversal = predictor.Predict(116000);
+    CHECK(afterReversal.x == 1.0f && afterReversal.y == 2.0f);
+}
+
+TEST(SameTimestampReplacesSample) {
+    MotionPredictor predictor;
+    predictor.AddSample(1000, 0.0f, 0.0f);
+    predictor.AddSample(2000, 1.0f, 0.0f);
+    predictor.AddSample(2000, 2.0f, 0.0f);
+
+    // Two samples remain: (1 ms, 0) and (2 ms, 2), a velocity of 2 px/ms
+    MotionPredictor::Point p = predictor.Predict(3000);
+    CHECK(std::fabs(p.x - 4.0f) < 1e-3f);
+}
+
+TEST(StatsUseNearestRankPercentiles) {
+    LatencyStats stats;
+    CHECK(stats.Percentile(0.5) == 0);
+    CHECK(stats.Mean() == 0.0);
+
+    for (int64_t i = 1; i <= 100; ++i) stats.Add(i * 100);
+    stats.Add(-5);
+
+    CHECK(stats.GetCount() == 100);
+    CHECK(stats.Percentile(0.0) == 100);
+    CHECK(stats.Percentile(0.5) == 5000);
+    CHECK(stats.Percentile(0.9) == 9000);
+    CHECK(stats.Percentile(0.99) == 9900);
+    CHECK(stats.Percentile(1.0) == 10000);
+    CHECK(stats.Max() == 10000);
+    CHECK(std::fabs(stats.Mean() - 5050.0) < 1e-9);
+}
+
+TEST(StatsKeepTheMostRecentWindow) {
+    LatencyStats stats(10);
+    for (int64_t i = 0; i < 25; ++i) stats.Add(i);
+
+    CHECK(stats.GetCount() == 10);
+    CHECK(stats.GetTotalCount() == 25);
+    CHECK(stats.Percentile(0.0) == 15);
+    CHECK(stats.Max() == 24);
+
+    stats.Reset();
+    CHECK(stats.GetCount() == 0);
+    CHECK(stats.GetTotalCount() == 0);
+}
+
+TEST(ReportShowsMilliseconds) {
+    LatencyStats stats;
+    for (int i = 0; i < 4; ++i) stats.Add(16667);
+
+    std::ostringstream out;
+    stats.WriteReport(out, "input-to-present");
+    std::string line = out.str();
+    CHECK(line.find("input-to-present") == 0);
+    CHECK(line.find("n=4") != std::string::npos);
+    CHECK(line.find("p50   16.67 ms") != std::string::npos);
+}
+
+TEST(ClockIsMonotonic) {
+    int64_t previous = LatencyClock::NowUs();
+    for (int i = 0; i < 1000; ++i) {
+        int64_t now = LatencyClock::NowUs();
+        CHECK(now >= previous);
+        previous = now;
+    }
+}
+
+int main() {
+    return RunTests();
+}
@@ -0,0 +1,227 @@
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "OverlayScene.hpp"
+#include "TestHarness.hpp"
+
+static bool CompileText(const std::string& text, std::vector<uint8_t>& output, std::string* error = nullptr) {
+    std::istringstream input(text);
+    return OverlaySceneCompiler::Compile(input, output, error);
+}
+
+static std::u16string TextOf(const OverlaySceneView& view, const SceneElement& element) {
+    const char16_t* text = view.GetText(element);
+    return text ? std::u16string(text, element.textLength) : std::u16string();
+}
+
+TEST(CompilesEveryElementType) {
+    std::vector<uint8_t> blob;
+    std::string error;
+    REQUIRE(CompileText(
+        "canvas 1920 1080\n"
+        "line 0 0 100 50 2 #ff0000\n"
+        "circle 10 20 5 #00ff0080\n"
+        "ring 10 20 5 1.5 #0000ff\n"
+        "diamond 10 20 5 1 #ffffff\n"
+        "cornerbox 1 2 3 4 1 #000000\n"
+        "rect 1 2 3 4 #123456 low\n"
+        "frame 1 2 3 4 2 #abcdef\n"
+        "text 5 6 14 #ffffff \"Hi \\\"there\\\"\"\n",
+        blob, &error));
+
+    OverlaySceneView view;
+    REQUIRE(view.Attach(blob.data(), blob.size()));
+    CHECK(view.GetHeader().designWidth == 1920.0f);
+    CHECK(view.GetHeader().designHeight == 1080.0f);
+    REQUIRE(view.GetElementCount() == 8);
+
+    const SceneElement* elements = view.GetElements();
+    CHECK(elements[0].type == (uint16_t)SceneElementType::Line);
+    CHECK(elements[0].color == 0xFF0000FFu);
+    CHECK(elements[0].x1 == 100.0f && elements[0].stroke == 2.0f);
+    CHECK(elements[1].type == (uint16_t)SceneElementType::SolidCircle);
+    CHECK(elements[1].color == 0x00FF0080u);
+    CHECK(elements[2].type == (uint16_t)SceneElementType::HollowCircle);
+    CHECK(elements[2].stroke == 1.5f);
+    CHECK(elements[3].type == (uint16_t)SceneElementType::HollowDiamond);
+    CHECK(elements[4].type == (uint16_t)SceneElementType::CornerBox);
+    CHECK(elements[5].type == (uint16_t)SceneElementType::SolidRectangle);
+    CHECK(elements[5].flags == kSceneFlagLowPriority);
+    CHECK(elements[6].type == (uint16_t)SceneElementType::HollowRectangle);
+    CHECK(elements[6].flags == 0);
+    CHECK(elements[7].type == (uint16_t)SceneElementType::Text);
+    CHECK(TextOf(view, elements[7]) == u"Hi \"there\"");
+}
+
+TEST(CommentsStartingWithHexLettersAreComments) {
+    std::vector<uint8_t> blob;
+    std::string error;
+    bool ok = CompileText(
+        "#add a marker below\n"
+        "#define nothing\n"
+        "# plain comment\n"
+        "#deadbe\n"
+        "circle 1 2 3 #ff0000 #add trailing comment\n"
+        "circle 1 2 3 #ff0000#notacolor\n"
+        "text 0 0 12 #ffffff \"# not a comment\" # comment\n",
+        blob, &error);
+    CHECK(!ok);
+    CHECK(error.find("line 4") == 0);
+
+    REQUIRE(CompileText(
+        "#add a marker below\n"
+        "#define nothing\n"
+        "# plain comment\n"
+        "circle 1 2 3 #ff0000 #add trailing comment\n"
+        "circle 1 2 3 #ff000080 #coffee\n"
+        "text 0 0 12 #ffffff \"# not a comment\" # comment\n",
+        blob, &error));
+
+    OverlaySceneView view;
+    REQUIRE(view.Attach(blob.data(), blob.size()));
+    REQUIRE(view.GetElementCount() == 3);
+    CHECK(view.GetElements()[1].color == 0xFF000080u);
+    CHECK(TextOf(view, view.GetElements()[2]) == u"# not a comment");
+}
+
+TEST(RejectsMalformedLines) {
+    std::vector<uint8_t> blob;
+    std::string error;
+
+    CHECK(!CompileText("canvas 100 100 extra\n", blob, &error));
+    CHECK(error == "line 1: unexpected 'extra'");
+    CHECK(!CompileText("canvas 0 100\n", blob, &error));
+    CHECK(!CompileText("canvas nan 100\n", blob, &error));
+    CHECK(!CompileText("\n\nsquare 1 2 3 #ffffff\n", blob, &error));
+    CHECK(error == "line 3: unknown element 'square'");
+    CHECK(!CompileText("circle 1 2 #ffffff\n", blob, &error));
+    CHECK(!CompileText("circle 1 2 3 #fffff\n", blob, &error));
+    CHECK(!CompileText("circle 1 2 3 #ffffff high\n", blob, &error));
+    CHECK(!CompileText("circle 1 2 3 #ffffff low low\n", blob, &error));
+    CHECK(!CompileText("text 1 2 3 #ffffff unquoted\n", blob, &error));
+    CHECK(!CompileText("text 1 2 3 #ffffff \"\xC3\"\n", blob, &error));
+
+    // Colors are hex digits only, with no sign
+    CHECK(!CompileText("circle 1 2 3 #-FFFFF\n", blob, &error));
+    CHECK(!CompileText("circle 1 2 3 #+ff00ff\n", blob, &error));
+    CHECK(!CompileText("circle 1 2 3 #-ffffff0\n", blob, &error));
+    CHECK(!CompileText("circle 1 2 3 #ff00gg\n", blob, &error));
+}
+
+TEST(EscapedQuotesDoNotEndStrings) {
+    std::vector<uint8_t> blob;
+    std::string error;
+    REQUIRE(CompileText(
+        "text 10 10 12 #ffffff \"a \\\" # b\" # comment\n"
+        "text 10 10 12 #ffffff \"back\\\\\" # comment\n",
+        blob, &error));
+
+    OverlaySceneView view;
+    REQUIRE(view.Attach(blob.data(), blob.size()));
+    REQUIRE(view.GetElementCount() == 2);
+    CHECK(TextOf(view, view.GetElements()[0]) == u"a \" # b");
+    CHECK(TextOf(view, view.GetElements()[1]) == u"back\\");
+}
+
+TEST(EncodesTextAsUtf16) {
+    std::vector<uint8_t> blob;
+    REQUIRE(CompileText("text 0 0 12 #ffffff \"a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\"\n", blob));
+
+    OverlaySceneView view;
+    REQUIRE(view.Attach(blob.data(), blob.size()));
+    CHECK(TextOf(view, view.GetElements()[0]) == u"aé€\U0001F600");
+    CHECK(view.GetElements()[0].textLength == 5);
+}
+
+TEST(AttachValidatesHeader) {
+    std::vector<uint8_t> blob;
+    REQUIRE(CompileText("circle 1 2 3 #ffffff\ntext 0 0 12 #ffffff \"x\"\n", blob));
+
+    OverlaySceneView view;
+    CHECK(view.Attach(blob.data(), blob.size()));
+    CHECK(!view.Attach(nullptr, blob.size()));
+    CHECK(!view.Attach(blob.data(), sizeof(SceneHeader) - 1));
+    CHECK(!view.Attach(blob.data(), blob.size() - 1));
+
+    std::vector<uint8_t> copy = blob;
+    copy[0] = 'X';
+    CHECK(!view.Attach(copy.data(), copy.size()));
+
+    copy = blob;
+    reinterpret_cast<SceneHeader*>(copy.data())->elementCount = 1000;
+    CHECK(!view.Attach(copy.data(), copy.size()));
+
+    copy = blob;
+    reinterpret_cast<SceneHeader*>(copy.data())->designWidth = std::numeric_limits<float>::quiet_NaN();
+    CHECK(!view.Attach(copy.data(), copy.size()));
+
+    copy = blob;
+    reinterpret_cast<SceneHeader*>(copy.data())->designHeight = -1.0f;
+    CHECK(!view.Attach(copy.data(), copy.size()));
+    CHECK(!view.IsValid());
+    CHECK(view.GetElementCount() == 0);
+
+    // Misaligned base
+    std::vector<uint64_t> aligned(blob.size() / 8 + 2);
+    uint8_t* shifted = reinterpret_cast<uint8_t*>(aligned.data()) + 4;
+    memcpy(shifted, blob.data(), blob.size());
+    CHECK(!view.Attach(shifted, blob.size()));
+}
+
+TEST(TextReferencesAreBoundsChecked) {
+    std::vector<uint8_t> blob;
+    REQUIRE(CompileText("text 0 0 12 #ffffff \"abc\"\n", blob));
+
+    OverlaySceneView view;
+    REQUIRE(view.Attach(blob.data(), blob.size()));
+
+    SceneElement element = view.GetElements()[0];
+    CHECK(view.GetText(element) != nullptr);
+
+    element.textLength = 1000;
+    CHECK(view.GetText(element) == nullptr);
+
+    element = view.GetElements()[0];
+    element.textOffset = 1;
+    CHECK(view.GetText(element) == nullptr);
+
+    element = view.GetElements()[0];
+    element.textLength = 2; // Points at 'c' instead of the terminator
+    CHECK(view.GetText(element) == nullptr);
+}
+
+TEST(MapsCompiledFile) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::filesystem::path input = directory / "overlay_scene_test.txt";
+    std::filesystem::path output = directory / "overlay_scene_test.ovs";
+
+    {
+        std::ofstream file(input);
+        file << "canvas 800 600\nring 400 300 50 2 #00ff00\n";
+    }
+
+    std::string error;
+    REQUIRE(OverlaySceneCompiler::CompileFile(input.string().c_str(), output.string().c_str(), &error));
+
+    OverlaySceneFile scene;
+    REQUIRE(scene.Open(output.string().c_str()));
+    CHECK(scene.GetView().GetElementCount() == 1);
+    CHECK(scene.GetView().GetElements()[0].size == 50.0f);
+    scene.Close();
+    CHECK(!scene.GetView().IsValid());
+
+    CHECK(!scene.Open((directory / "overlay_scene_missing.ovs").string().c_str()));
+    CHECK(!OverlaySceneCompiler::CompileFile((directory / "overlay_scene_missing.txt").string().c_str(), output.string().c_str(), &error));
+
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+}
+
+int main() {
+    return RunTests();
+}
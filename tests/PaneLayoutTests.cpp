@@ -0,0 +1,244 @@
+#include <cmath>
+#include <cstddef>
+#include <set>
+#include <vector>
+
+#include "PaneLayout.hpp"
+#include "TestHarness.hpp"
+
+// Stands in for the DWM thumbnail handles behind the panes: records what each one was
+// last given and fails updates for the panes marked as broken.
+struct FakeThumbnails {
+    std::vector<PaneGeometry> applied;
+    std::vector<int> updates;
+    std::set<size_t> failing;
+    int calls = 0;
+
+    explicit FakeThumbnails(size_t count)
+        : applied(count, PaneGeometry{ { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, false, 0 }),
+        updates(count, 0) {}
+
+    bool operator()(size_t index, const PaneGeometry& geometry) {
+        calls++;
+        if (failing.count(index)) return false;
+
+        applied[index] = geometry;
+        updates[index]++;
+        return true;
+    }
+};
+
+static size_t Update(PaneLayout& layout, FakeThumbnails& thumbnails, const PaneRect& source, int width, int height) {
+    return layout.Update(source, width, height, [&](size_t index, const PaneGeometry& geometry) {
+        return thumbnails(index, geometry);
+    });
+}
+
+static PaneSpec Region(float left, float top, float right, float bottom, float destLeft, float destTop, float destRight, float destBottom) {
+    PaneSpec spec;
+    spec.sourceLeft = left;
+    spec.sourceTop = top;
+    spec.sourceRight = right;
+    spec.sourceBottom = bottom;
+    spec.destLeft = destLeft;
+    spec.destTop = destTop;
+    spec.destRight = destRight;
+    spec.destBottom = destBottom;
+    return spec;
+}
+
+TEST(FullPaneLetterboxesLikeTheMainThumbnail) {
+    PaneLayout layout;
+    layout.AddPane(PaneSpec());
+    FakeThumbnails thumbnails(1);
+
+    // 16:9 source in a 4:3 clone window: full width, centred vertically
+    CHECK(Update(layout, thumbnails, { 8, 31, 1928, 1111 }, 800, 600) == 1);
+    const PaneGeometry& geometry = thumbnails.applied[0];
+    CHECK(geometry.source == (PaneRect{ 8, 31, 1928, 1111 }));
+    CHECK(geometry.destination == (PaneRect{ 0, 75, 800, 525 }));
+    CHECK(geometry.visible);
+    CHECK(geometry.opacity == 255);
+
+    // Tall source: full height, centred horizontally
+    CHECK(Update(layout, thumbnails, { 0, 0, 500, 1000 }, 800, 600) == 1);
+    CHECK(thumbnails.applied[0].destination == (PaneRect{ 250, 0, 550, 600 }));
+}
+
+TEST(OnlyChangedPanesAreCommitted) {
+    PaneLayout layout;
+    layout.AddPane(PaneSpec());
+    layout.AddPane(Region(0.4f, 0.4f, 0.6f, 0.6f, 0.7f, 0.0f, 1.0f, 0.3f));
+    layout.AddPane(Region(0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.8f, 0.2f, 1.0f));
+    FakeThumbnails thumbnails(3);
+
+    PaneRect source = { 0, 0, 1600, 900 };
+    CHECK(Update(layout, thumbnails, source, 1280, 720) == 3);
+    CHECK(thumbnails.calls == 3);
+
+    // Nothing moved: no calls at all
+    CHECK(Update(layout, thumbnails, source, 1280, 720) == 0);
+    CHECK(thumbnails.calls == 3);
+
+    // Changing one pane's spec touches only that pane
+    PaneSpec zoom = layout.GetPane(1);
+    zoom.opacity = 128;
+    CHECK(layout.SetPane(1, zoom));
+    CHECK(Update(layout, thumbnails, source, 1280, 720) == 1);
+    CHECK(thumbnails.updates[0] == 1 && thumbnails.updates[1] == 2 && thumbnails.updates[2] == 1);
+    CHECK(thumbnails.applied[1].opacity == 128);
+
+    // Resizing the clone window moves every pane
+    CHECK(Update(layout, thumbnails, source, 1920, 1080) == 3);
+}
+
+TEST(FailedCommitsAreRetried) {
+    PaneLayout layout;
+    layout.AddPane(PaneSpec());
+    layout.AddPane(Region(0.0f, 0.0f, 0.5f, 0.5f, 0.5f, 0.5f, 1.0f, 1.0f));
+    FakeThumbnails thumbnails(2);
+
+    thumbnails.failing.insert(1);
+    CHECK(Update(layout, thumbnails, { 0, 0, 1000, 1000 }, 500, 500) == 1);
+    CHECK(thumbnails.updates[1] == 0);
+
+    // The failing pane is offered again every pass until it takes
+    CHECK(Update(layout, thumbnails, { 0, 0, 1000, 1000 }, 500, 500) == 0);
+    CHECK(thumbnails.calls == 3);
+
+    thumbnails.failing.clear();
+    CHECK(Update(layout, thumbnails, { 0, 0, 1000, 1000 }, 500, 500) == 1);
+    CHECK(thumbnails.applied[1].source == (PaneRect{ 0, 0, 500, 500 }));
+    CHECK(thumbnails.applied[1].destination == (PaneRect{ 250, 250, 500, 500 }));
+
+    CHECK(Update(layout, thumbnails, { 0, 0, 1000, 1000 }, 500, 500) == 0);
+}
+
+TEST(InvalidateRecommitsUnchangedGeometry) {
+    PaneLayout layout;
+    layout.AddPane(PaneSpec());
+    layout.AddPane(PaneSpec());
+    FakeThumbnails thumbnails(2);
+
+    Update(layout, thumbnails, { 0, 0, 640, 480 }, 640, 480);
+
+    // A recreated thumbnail has lost its properties
+    layout.Invalidate(1);
+    layout.Invalidate(7);
+    CHECK(Update(layout, thumbnails, { 0, 0, 640, 480 }, 640, 480) == 1);
+    CHECK(thumbnails.updates[0] == 1 && thumbnails.updates[1] == 2);
+}
+
+TEST(EmptyAndHiddenPanes) {
+    PaneLayout layout;
+    layout.AddPane(Region(0.5f, 0.5f, 0.5f, 0.9f, 0.0f, 0.0f, 1.0f, 1.0f)); // No source width
+    PaneSpec hidden;
+    hidden.visible = false;
+    layout.AddPane(hidden);
+    FakeThumbnails thumbnails(2);
+
+    // Minimized clone window: nothing has an area
+    Update(layout, thumbnails, { 0, 0, 800, 600 }, 0, 0);
+    CHECK(!thumbnails.applied[0].visible && !thumbnails.applied[1].visible);
+    CHECK(thumbnails.applied[1].destination.IsEmpty());
+
+    Update(layout, thumbnails, { 0, 0, 800, 600 }, 800, 600);
+    CHECK(!thumbnails.applied[0].visible);
+    CHECK(thumbnails.applied[0].source.IsEmpty());
+    CHECK(!thumbnails.applied[1].visible);
+    CHECK(!thumbnails.applied[1].destination.IsEmpty());
+
+    PaneMapping mapping;
+    CHECK(!layout.GetMapping(0, &mapping));
+    CHECK(!layout.GetMapping(1, &mapping));
+    CHECK(!layout.GetMapping(2, &mapping));
+    CHECK(!layout.SetPane(2, hidden));
+}
+
+TEST(MappingRoundTripsThroughAZoomPane) {
+    PaneLayout layout;
+    layout.AddPane(PaneSpec());
+    size_t zoom = layout.AddPane(Region(0.4f, 0.4f, 0.6f, 0.6f, 0.7f, 0.0f, 1.0f, 0.3f));
+    FakeThumbnails thumbnails(2);
+
+    // Source client area offset inside its window by the frame
+    Update(layout, thumbnails, { 8, 31, 808, 631 }, 1000, 750);
+
+    PaneMapping mapping;
+    REQUIRE(layout.GetMapping(zoom, &mapping));
+
+    // Mapping works in source client coordinates, without the frame offset
+    CHECK(mapping.source == (PaneRect{ 320, 240, 480, 360 }));
+    CHECK(std::fabs(mapping.scaleX - mapping.scaleY) < 0.01f);
+
+    float destX, destY, sourceX, sourceY;
+    mapping.ToDestination(400.0f, 300.0f, &destX, &destY);
+    CHECK(mapping.ContainsDestination(destX, destY));
+    CHECK(std::fabs(destX - (mapping.destination.left + mapping.destination.right) / 2.0f) < 1.0f);
+
+    mapping.ToSource(destX, destY, &sourceX, &sourceY);
+    CHECK(std::fabs(sourceX - 400.0f) < 0.01f && std::fabs(sourceY - 300.0f) < 0.01f);
+
+    // Source pixels outside the zoomed region land outside the pane
+    mapping.ToDestination(100.0f, 100.0f, &destX, &destY);
+    CHECK(!mapping.ContainsDestination(destX, destY));
+}
+
+TEST(OverlayTransformFollowsSourceContent) {
+    PaneLayout layout;
+    layout.AddPane(PaneSpec());
+    size_t zoom = layout.AddPane(Region(0.4f, 0.4f, 0.6f, 0.6f, 0.7f, 0.0f, 1.0f, 0.3f));
+    PaneSpec hidden;
+    hidden.visible = false;
+    size_t off = layout.AddPane(hidden);
+    FakeThumbnails thumbnails(3);
+
+    // Letterboxed main pane, so the overlay origin is not the clone window origin
+    Update(layout, thumbnails, { 8, 31, 1608, 931 }, 1000, 750);
+
+    PaneTransform transform;
+    REQUIRE(layout.GetOverlayTransform(0, &transform));
+    CHECK(transform.scaleX == 1.0f && transform.scaleY == 1.0f);
+    CHECK(transform.offsetX == 0.0f && transform.offsetY == 0.0f);
+
+    PaneMapping main, pane;
+    REQUIRE(layout.GetMapping(0, &main));
+    REQUIRE(layout.GetMapping(zoom, &pane));
+    REQUIRE(layout.GetOverlayTransform(zoom, &transform));
+    CHECK(transform.clip == (PaneRect{ pane.destination.left - main.destination.left, pane.destination.top - main.destination.top,
+        pane.destination.right - main.destination.left, pane.destination.bottom - main.destination.top }));
+
+    // An overlay point lands where the zoom pane shows the same source point
+    const float points[][2] = { { 500.0f, 281.0f }, { 0.0f, 0.0f }, { 1000.0f, 562.0f } };
+    for (const auto& point : points) {
+        float sourceX, sourceY, destX, destY, x, y;
+        main.ToSource(main.destination.left + point[0], main.destination.top + point[1], &sourceX, &sourceY);
+        pane.ToDestination(sourceX, sourceY, &destX, &destY);
+        transform.Apply(point[0], point[1], &x, &y);
+        CHECK(std::fabs(x - (destX - main.destination.left)) < 0.01f);
+        CHECK(std::fabs(y - (destY - main.destination.top)) < 0.01f);
+    }
+
+    CHECK(!layout.GetOverlayTransform(off, &transform));
+    CHECK(!layout.GetOverlayTransform(7, &transform));
+}
+
+TEST(StretchedPaneFillsItsArea) {
+    PaneLayout layout;
+    PaneSpec stretched = Region(0.0f, 0.0f, 1.0f, 0.5f, 0.0f, 0.0f, 0.5f, 1.0f);
+    stretched.keepAspect = false;
+    layout.AddPane(stretched);
+    FakeThumbnails thumbnails(1);
+
+    Update(layout, thumbnails, { 0, 0, 1000, 1000 }, 400, 300);
+    CHECK(thumbnails.applied[0].source == (PaneRect{ 0, 0, 1000, 500 }));
+    CHECK(thumbnails.applied[0].destination == (PaneRect{ 0, 0, 200, 300 }));
+
+    PaneMapping mapping;
+    REQUIRE(layout.GetMapping(0, &mapping));
+    CHECK(mapping.scaleX == 0.2f && mapping.scaleY == 0.6f);
+}
+
+int main() {
+    return RunTests();
+}
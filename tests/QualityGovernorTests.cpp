@@ -0,0 +1,204 @@
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "QualityGovernor.hpp"
+#include "TestHarness.hpp"
+
+// Synthetic load traces. A trace gives the frame time for a frame index and the current
+// tier, so tier-dependent costs (the load the governor is shedding) can be modeled.
+using LoadTrace = std::function<int64_t(size_t frame, QualityTier tier)>;
+
+struct TraceResult {
+    std::vector<QualityTier> tiers; // Tier after each frame
+    size_t changes = 0;
+};
+
+static TraceResult Run(QualityGovernor& governor, size_t frames, const LoadTrace& trace, size_t start = 0) {
+    TraceResult result;
+    for (size_t i = start; i < start + frames; ++i) {
+        if (governor.AddFrame(trace(i, governor.GetTier()))) result.changes++;
+        result.tiers.push_back(governor.GetTier());
+    }
+    return result;
+}
+
+static QualityGovernorConfig TestConfig() {
+    QualityGovernorConfig config;
+    config.budgetUs = 8000;
+    config.windowFrames = 10;
+    config.upgradeWindows = 2;
+    config.maxUpgradeWindows = 16;
+    return config;
+}
+
+TEST(LightLoadStaysAtFullQuality) {
+    QualityGovernor governor(TestConfig());
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int64_t> load(1000, 5000);
+
+    TraceResult result = Run(governor, 1000, [&](size_t, QualityTier) { return load(random); });
+    CHECK(result.changes == 0);
+    CHECK(governor.GetTier() == QualityTier::Full);
+    CHECK(governor.GetMinFrameIntervalUs() == 0);
+}
+
+TEST(SustainedOverloadDropsOneTierPerWindow) {
+    QualityGovernor governor(TestConfig());
+    TraceResult result = Run(governor, 100, [](size_t, QualityTier) { return (int64_t)20000; });
+
+    // A tier per 10-frame window until the last one, never past it. The refresh cap cannot
+    // make frames cheaper, so the drop after AliasedSmallShapes goes straight to skipping
+    // low-priority layers, which keeps the cap.
+    CHECK(result.tiers[9] == QualityTier::NoOuterOutline);
+    CHECK(result.tiers[19] == QualityTier::AliasedSmallShapes);
+    CHECK(result.tiers[29] == QualityTier::EssentialOnly);
+    CHECK(result.changes == 3);
+    for (QualityTier tier : result.tiers) CHECK(tier != QualityTier::ReducedRate);
+    CHECK(governor.GetMinFrameIntervalUs() == TestConfig().reducedFrameIntervalUs);
+}
+
+TEST(ReducedRateIsOnlyAStepOnTheWayUp) {
+    // Frame cost depends on the content drawn, never on the refresh cap: low-priority layers
+    // cost 6 ms, everything else 3 ms
+    QualityGovernor governor(TestConfig());
+    LoadTrace layers = [](size_t, QualityTier tier) {
+        return tier == QualityTier::EssentialOnly ? (int64_t)3000 : (int64_t)9000;
+    };
+
+    Run(governor, 30, layers);
+    REQUIRE(governor.GetTier() == QualityTier::EssentialOnly);
+
+    // Calm at EssentialOnly raises to ReducedRate, which brings the layers back under the
+    // cap; they are over budget again, so it returns to EssentialOnly without passing
+    // through an uncapped tier
+    TraceResult result = Run(governor, 200, layers);
+    bool capped = true;
+    for (size_t i = 0; i < result.tiers.size(); ++i) {
+        capped &= result.tiers[i] == QualityTier::ReducedRate || result.tiers[i] == QualityTier::EssentialOnly;
+    }
+    CHECK(capped);
+    CHECK(result.changes >= 2);
+
+    // Once the layers are cheap, the cap is lifted only after ReducedRate has been calm
+    TraceResult calm = Run(governor, 3000, [](size_t, QualityTier) { return (int64_t)2000; });
+    size_t reduced = 0;
+    for (size_t i = 0; i < calm.tiers.size() && calm.tiers[i] != QualityTier::AliasedSmallShapes; ++i) {
+        reduced += calm.tiers[i] == QualityTier::ReducedRate;
+    }
+    CHECK(reduced >= 2 * TestConfig().windowFrames);
+    CHECK(governor.GetTier() == QualityTier::Full);
+    CHECK(governor.GetMinFrameIntervalUs() == 0);
+}
+
+TEST(IsolatedSpikesAreIgnored) {
+    // One slow frame per window sits above the 90th percentile of ten frames
+    QualityGovernor governor(TestConfig());
+    TraceResult result = Run(governor, 500, [](size_t frame, QualityTier) { return frame % 10 == 3 ? (int64_t)50000 : (int64_t)3000; });
+    CHECK(result.changes == 0);
+
+    // Two per window do not
+    TraceResult denser = Run(governor, 10, [](size_t frame, QualityTier) { return frame % 5 == 3 ? (int64_t)50000 : (int64_t)3000; });
+    CHECK(denser.changes == 1);
+}
+
+TEST(RecoversAfterLoadEnds) {
+    QualityGovernor governor(TestConfig());
+    Run(governor, 40, [](size_t, QualityTier) { return (int64_t)20000; });
+    REQUIRE(governor.GetTier() == QualityTier::EssentialOnly);
+
+    // Two calm windows per tier
+    TraceResult result = Run(governor, 80, [](size_t, QualityTier) { return (int64_t)2000; });
+    CHECK(result.tiers[19] == QualityTier::ReducedRate);
+    CHECK(result.tiers[79] == QualityTier::Full);
+    CHECK(result.changes == 4);
+}
+
+TEST(HysteresisBandHolds) {
+    QualityGovernor governor(TestConfig());
+    Run(governor, 10, [](size_t, QualityTier) { return (int64_t)20000; });
+    REQUIRE(governor.GetTier() == QualityTier::NoOuterOutline);
+
+    // Between 60% and 100% of the budget: neither calm nor over
+    std::mt19937 random(2);
+    std::uniform_int_distribution<int64_t> load(5000, 7900);
+    TraceResult result = Run(governor, 1000, [&](size_t, QualityTier) { return load(random); });
+    CHECK(result.changes == 0);
+}
+
+TEST(BoundaryLoadSettlesInsteadOfOscillating) {
+    // The outer outline costs just enough to go over budget; without it the frame is calm.
+    // Each bounce doubles the calm windows needed before the next attempt.
+    QualityGovernor governor(TestConfig());
+    LoadTrace trace = [](size_t, QualityTier tier) { return tier == QualityTier::Full ? (int64_t)9000 : (int64_t)4000; };
+
+    TraceResult result = Run(governor, 4000, trace);
+    CHECK(governor.GetRequiredCalmWindows() == TestConfig().maxUpgradeWindows);
+
+    // Attempts thin out: 2, 4, 8 then every 16 windows
+    size_t lateChanges = 0;
+    for (size_t i = 2000; i < result.tiers.size(); ++i) lateChanges += result.tiers[i] != result.tiers[i - 1];
+    CHECK(lateChanges <= 2 * (2000 / (10 * 16)) + 2);
+
+    size_t full = 0;
+    for (QualityTier tier : result.tiers) full += tier == QualityTier::Full;
+    CHECK(full < result.tiers.size() / 8);
+}
+
+TEST(BackoffShrinksOnceATierHolds) {
+    QualityGovernor governor(TestConfig());
+    LoadTrace boundary = [](size_t, QualityTier tier) { return tier == QualityTier::Full ? (int64_t)9000 : (int64_t)4000; };
+    Run(governor, 600, boundary);
+    size_t backedOff = governor.GetRequiredCalmWindows();
+    CHECK(backedOff > TestConfig().upgradeWindows);
+
+    // The load goes away; a raised tier that holds halves the wait each time
+    Run(governor, 2000, [](size_t, QualityTier) { return (int64_t)2000; });
+    CHECK(governor.GetTier() == QualityTier::Full);
+    CHECK(governor.GetRequiredCalmWindows() < backedOff);
+}
+
+TEST(SlowRampIsTracked) {
+    // Load climbs from 2 ms to 30 ms and back over 2000 frames
+    QualityGovernor governor(TestConfig());
+    LoadTrace ramp = [](size_t frame, QualityTier) {
+        int64_t position = (int64_t)(frame < 1000 ? frame : 2000 - frame);
+        return (int64_t)2000 + position * 28;
+    };
+
+    TraceResult result = Run(governor, 2000, ramp);
+    CHECK(result.tiers[999] == QualityTier::EssentialOnly);
+    CHECK(result.tiers[1999] == QualityTier::Full);
+
+    // Tiers only ever move by one step at a time, except the drop past ReducedRate
+    bool single = true;
+    for (size_t i = 1; i < result.tiers.size(); ++i) {
+        int step = (int)result.tiers[i] - (int)result.tiers[i - 1];
+        bool skip = result.tiers[i - 1] == QualityTier::AliasedSmallShapes && result.tiers[i] == QualityTier::EssentialOnly;
+        single &= (step >= -1 && step <= 1) || skip;
+    }
+    CHECK(single);
+}
+
+TEST(ResetAndSetConfig) {
+    QualityGovernor governor(TestConfig());
+    Run(governor, 20, [](size_t, QualityTier) { return (int64_t)20000; });
+    REQUIRE(governor.GetTier() == QualityTier::AliasedSmallShapes);
+    CHECK(governor.IsAtLeast(QualityTier::NoOuterOutline));
+    CHECK(!governor.IsAtLeast(QualityTier::ReducedRate));
+
+    governor.Reset();
+    CHECK(governor.GetTier() == QualityTier::Full);
+
+    // A larger budget turns the same load into a calm one
+    QualityGovernorConfig config = TestConfig();
+    config.budgetUs = 50000;
+    governor.SetConfig(config);
+    TraceResult result = Run(governor, 100, [](size_t, QualityTier) { return (int64_t)20000; });
+    CHECK(result.changes == 0);
+}
+
+int main() {
+    return RunTests();
+}
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "SpatialGrid.hpp"
+#include "TestHarness.hpp"
+
+// Brute-force model the grid is checked against
+struct Model {
+    std::vector<SpatialRect> rects;
+    std::vector<bool> live;
+    std::vector<SpatialGrid::Handle> handles;
+};
+
+static bool Overlaps(const SpatialRect& a, const SpatialRect& b) {
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+static std::vector<SpatialGrid::Handle> Query(SpatialGrid& grid, const SpatialRect& rect) {
+    std::vector<SpatialGrid::Handle> found;
+    grid.QueryRect(rect, [&](SpatialGrid::Handle handle) { found.push_back(handle); return true; });
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+static std::vector<SpatialGrid::Handle> Expected(const Model& model, const SpatialRect& rect) {
+    std::vector<SpatialGrid::Handle> found;
+    for (size_t i = 0; i < model.rects.size(); ++i) {
+        if (model.live[i] && Overlaps(model.rects[i], rect)) found.push_back(model.handles[i]);
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+static SpatialRect RandomRect(std::mt19937& random) {
+    // Mostly small, some spanning many cells, some at negative coordinates
+    std::uniform_real_distribution<float> position(-300.0f, 1500.0f);
+    std::uniform_real_distribution<float> small(0.5f, 60.0f);
+    std::uniform_real_distribution<float> large(100.0f, 900.0f);
+    float left = position(random), top = position(random);
+    bool big = random() % 16 == 0;
+    return { left, top, left + (big ? large(random) : small(random)), top + (big ? large(random) : small(random)) };
+}
+
+static void CheckAgainstModel(SpatialGrid& grid, Model& model, std::mt19937& random, int operations) {
+    std::uniform_real_distribution<float> nudge(-3.0f, 3.0f);
+
+    for (int op = 0; op < operations; ++op) {
+        size_t index = random() % model.rects.size();
+        int action = (int)(random() % 10);
+
+        if (!model.live[index]) {
+            model.rects[index] = RandomRect(random);
+            model.handles[index] = grid.Insert(model.rects[index], (uint32_t)index);
+            model.live[index] = true;
+        }
+        else if (action == 0) {
+            grid.Remove(model.handles[index]);
+            model.live[index] = false;
+        }
+        else if (action < 4) {
+            model.rects[index] = RandomRect(random);
+            grid.Move(model.handles[index], model.rects[index]);
+        }
+        else {
+            // Small moves, which mostly stay in the same cells
+            SpatialRect& rect = model.rects[index];
+            float dx = nudge(random), dy = nudge(random);
+            rect = { rect.left + dx, rect.top + dy, rect.right + dx, rect.bottom + dy };
+            grid.Move(model.handles[index], rect);
+        }
+    }
+
+    size_t liveCount = (size_t)std::count(model.live.begin(), model.live.end(), true);
+    CHECK(grid.GetCount() == liveCount);
+
+    for (int q = 0; q < 200; ++q) {
+        SpatialRect rect = RandomRect(random);
+        CHECK(Query(grid, rect) == Expected(model, rect));
+    }
+}
+
+TEST(QueriesMatchBruteForce) {
+    std::mt19937 random(5);
+    SpatialGrid grid(32.0f);
+    Model model;
+    model.rects.resize(3000);
+    model.live.assign(3000, false);
+    model.handles.assign(3000, SpatialGrid::kInvalidHandle);
+
+    for (int round = 0; round < 5; ++round) CheckAgainstModel(grid, model, random, 20000);
+}
+
+TEST(BucketCollisionsAreHandled) {
+    // With two buckets nearly every cell of an element shares a bucket with another
+    std::mt19937 random(6);
+    SpatialGrid grid(16.0f, 2);
+    Model model;
+    model.rects.resize(300);
+    model.live.assign(300, false);
+    model.handles.assign(300, SpatialGrid::kInvalidHandle);
+
+    for (int round = 0; round < 3; ++round) CheckAgainstModel(grid, model, random, 5000);
+}
+
+TEST(SmallMovesAcrossCellEdges) {
+    SpatialGrid grid(32.0f);
+    SpatialGrid::Handle handle = grid.Insert({ 30.0f, 30.0f, 34.0f, 34.0f }, 1);
+
+    // Step across the cell edge at 32 and 64 in quarter pixels, both ways
+    for (int step = 0; step < 200; ++step) {
+        float x = 20.0f + (step < 100 ? step : 200 - step) * 0.5f;
+        grid.Move(handle, { x, x, x + 4.0f, x + 4.0f });
+
+        CHECK(grid.HitTest(x + 2.0f, x + 2.0f) == handle);
+        CHECK(grid.AnyOverlap({ x + 1.0f, x + 1.0f, x + 3.0f, x + 3.0f }));
+        CHECK(!grid.AnyOverlap({ x + 5.0f, x + 5.0f, x + 9.0f, x + 9.0f }));
+    }
+}
+
+TEST(GrowingAndShrinkingPastTheCellLimit) {
+    SpatialGrid grid(10.0f);
+    SpatialGrid::Handle handle = grid.Insert({ 0.0f, 0.0f, 5.0f, 5.0f }, 1);
+
+    grid.Move(handle, { 0.0f, 0.0f, 500.0f, 500.0f });
+    CHECK(grid.HitTest(450.0f, 450.0f) == handle);
+
+    grid.Move(handle, { 100.0f, 100.0f, 105.0f, 105.0f });
+    CHECK(grid.HitTest(450.0f, 450.0f) == SpatialGrid::kInvalidHandle);
+    CHECK(grid.HitTest(102.0f, 102.0f) == handle);
+    CHECK(Query(grid, { -1000.0f, -1000.0f, 1000.0f, 1000.0f }).size() == 1);
+}
+
+TEST(TouchingEdgesDoNotOverlap) {
+    SpatialGrid grid(32.0f);
+    grid.Insert({ 0.0f, 0.0f, 32.0f, 32.0f }, 1);
+    CHECK(!grid.AnyOverlap({ 32.0f, 0.0f, 64.0f, 32.0f }));
+    CHECK(grid.AnyOverlap({ 31.9f, 0.0f, 64.0f, 32.0f }));
+
+    // Points are inclusive
+    CHECK(grid.HitTest(32.0f, 32.0f) != SpatialGrid::kInvalidHandle);
+
+    // Empty and inverted query rectangles find nothing
+    CHECK(!grid.AnyOverlap({ 10.0f, 10.0f, 10.0f, 20.0f }));
+    CHECK(!grid.AnyOverlap({ 20.0f, 10.0f, 10.0f, 20.0f }));
+}
+
+TEST(HitTestPrefersTheLatestUpdate) {
+    SpatialGrid grid(32.0f);
+    SpatialGrid::Handle a = grid.Insert({ 0.0f, 0.0f, 50.0f, 50.0f }, 1);
+    SpatialGrid::Handle b = grid.Insert({ 10.0f, 10.0f, 60.0f, 60.0f }, 2);
+    CHECK(grid.HitTest(20.0f, 20.0f) == b);
+
+    // Re-submitting the same rectangle still raises the element
+    grid.Move(a, { 0.0f, 0.0f, 50.0f, 50.0f });
+    CHECK(grid.HitTest(20.0f, 20.0f) == a);
+    CHECK(grid.GetUserId(a) == 1);
+}
+
+TEST(RemoveStaleKeepsOnlyUpdatedElements) {
+    SpatialGrid grid(32.0f);
+    std::vector<SpatialGrid::Handle> handles;
+    for (int i = 0; i < 100; ++i) handles.push_back(grid.Insert({ i * 10.0f, 0.0f, i * 10.0f + 5.0f, 5.0f }, (uint32_t)i));
+
+    // Everything inserted in this pass is current
+    CHECK(grid.RemoveStale() == 0);
+    CHECK(grid.GetCount() == 100);
+
+    grid.BeginFrame();
+    for (int i = 0; i < 100; i += 2) grid.Move(handles[i], grid.GetRect(handles[i]));
+    grid.Move(handles[0], grid.GetRect(handles[0])); // Twice in one pass counts once
+    CHECK(grid.RemoveStale() == 50);
+    CHECK(grid.GetCount() == 50);
+    for (int i = 0; i < 100; ++i) CHECK(grid.IsLive(handles[i]) == (i % 2 == 0));
+
+    // Removing a current element does not make others look stale
+    grid.BeginFrame();
+    for (int i = 0; i < 100; i += 2) grid.Move(handles[i], grid.GetRect(handles[i]));
+    grid.Remove(handles[0]);
+    CHECK(grid.RemoveStale() == 0);
+    CHECK(grid.GetCount() == 49);
+
+    // Freed handles are reused
+    SpatialGrid::Handle reused = grid.Insert({ 0.0f, 0.0f, 1.0f, 1.0f }, 500);
+    CHECK(reused == handles[0] || !grid.IsLive(handles[1]));
+    CHECK(grid.GetUserId(reused) == 500);
+}
+
+TEST(NonFiniteRectanglesAreSafe) {
+    SpatialGrid grid(32.0f);
+    float nan = std::numeric_limits<float>::quiet_NaN();
+    float inf = std::numeric_limits<float>::infinity();
+
+    SpatialGrid::Handle a = grid.Insert({ nan, nan, nan, nan }, 1);
+    SpatialGrid::Handle b = grid.Insert({ -inf, 0.0f, inf, 10.0f }, 2);
+    grid.Move(a, { 0.0f, nan, 10.0f, 10.0f });
+    grid.QueryRect({ 0.0f, 0.0f, 100.0f, 100.0f }, [](SpatialGrid::Handle) { return true; });
+    CHECK(grid.HitTest(5.0f, 5.0f) == b);
+
+    grid.Remove(a);
+    grid.Remove(b);
+    CHECK(grid.GetCount() == 0);
+}
+
+TEST(ClearEmptiesTheGrid) {
+    SpatialGrid grid(32.0f);
+    for (int i = 0; i < 10000; ++i) grid.Insert({ (float)(i % 100) * 7.0f, (float)(i / 100) * 7.0f, (float)(i % 100) * 7.0f + 5.0f, (float)(i / 100) * 7.0f + 5.0f }, (uint32_t)i);
+    CHECK(grid.GetCount() == 10000);
+
+    grid.Clear();
+    CHECK(grid.GetCount() == 0);
+    CHECK(!grid.AnyOverlap({ -1e6f, -1e6f, 1e6f, 1e6f }));
+    CHECK(grid.RemoveStale() == 0);
+}
+
+int main() {
+    return RunTests();
+}
@@ -0,0 +1,207 @@
+#include <cstdint>
+#include <vector>
+
+#include "StampCache.hpp"
+#include "TestHarness.hpp"
+
+static uint32_t Alpha(uint32_t pixel) { return pixel >> 24; }
+static uint32_t Red(uint32_t pixel) { return (pixel >> 16) & 0xFF; }
+static uint32_t Green(uint32_t pixel) { return (pixel >> 8) & 0xFF; }
+static uint32_t Blue(uint32_t pixel) { return pixel & 0xFF; }
+
+TEST(ColorIsNotPartOfTheKey) {
+    StampCache cache;
+    const Stamp* first = cache.Find(StampCache::MakeKey(StampShape::HollowCircle, 6.0f, 6.0f, 1.5f));
+    REQUIRE(first);
+
+    // Animated colors reuse the stamp instead of filling the atlas
+    for (int frame = 0; frame < 100; ++frame) {
+        CHECK(cache.Find(StampCache::MakeKey(StampShape::HollowCircle, 6.0f, 6.0f, 1.5f)) == first);
+    }
+    CHECK(cache.GetStampCount() == 1);
+}
+
+TEST(SizesAreQuantizedToQuarterPixels) {
+    StampCache cache;
+    const Stamp* a = cache.Find(StampCache::MakeKey(StampShape::SolidCircle, 5.0f, 5.0f, 0.0f));
+    const Stamp* b = cache.Find(StampCache::MakeKey(StampShape::SolidCircle, 5.1f, 5.1f, 0.0f));
+    const Stamp* c = cache.Find(StampCache::MakeKey(StampShape::SolidCircle, 5.2f, 5.2f, 0.0f));
+    CHECK(a && a == b);
+    CHECK(c && c != a);
+
+    // Stroke is ignored for filled circles
+    CHECK(cache.Find(StampCache::MakeKey(StampShape::SolidCircle, 5.0f, 5.0f, 3.0f)) == a);
+}
+
+TEST(PeekDoesNotRasterize) {
+    StampCache cache;
+    StampKey key = StampCache::MakeKey(StampShape::HollowDiamond, 8.0f, 8.0f, 1.0f);
+    CHECK(!cache.Peek(key));
+    CHECK(cache.GetStampCount() == 0);
+
+    const Stamp* stamp = cache.Find(key);
+    CHECK(stamp && cache.Peek(key) == stamp);
+}
+
+TEST(StampsAreWhiteCoverageWithTransparentBorder) {
+    StampCache cache;
+    for (StampShape shape : { StampShape::SolidCircle, StampShape::HollowCircle, StampShape::HollowDiamond, StampShape::CornerBox }) {
+        const Stamp* stamp = cache.Find(StampCache::MakeKey(shape, 10.0f, shape == StampShape::CornerBox ? 7.0f : 10.0f, 2.0f));
+        REQUIRE(stamp);
+
+        const uint32_t* pixels = cache.GetPixels();
+        bool white = true, border = true, covered = false;
+        for (int y = 0; y < stamp->rect.height; ++y) {
+            for (int x = 0; x < stamp->rect.width; ++x) {
+                uint32_t p = pixels[(size_t)(stamp->rect.y + y) * cache.GetWidth() + stamp->rect.x + x];
+                white &= Red(p) == Alpha(p) && Green(p) == Alpha(p) && Blue(p) == Alpha(p);
+                if (x == 0 || y == 0 || x == stamp->rect.width - 1 || y == stamp->rect.height - 1) border &= p == 0;
+                covered |= Alpha(p) == 255;
+            }
+        }
+        CHECK(white);
+        CHECK(border);
+        CHECK(covered);
+    }
+}
+
+TEST(OversizedShapesAreNotStamped) {
+    StampCache cache;
+    CHECK(!cache.Find(StampCache::MakeKey(StampShape::SolidCircle, 100.0f, 100.0f, 0.0f)));
+    CHECK(cache.GetStampCount() == 0);
+}
+
+TEST(FullAtlasIsClearedAndGenerationBumped) {
+    StampCache cache(64, 64);
+    uint32_t generation = cache.GetGeneration();
+
+    float radius = 2.0f;
+    while (cache.GetGeneration() == generation) {
+        REQUIRE(radius < 30.0f);
+        CHECK(cache.Find(StampCache::MakeKey(StampShape::SolidCircle, radius, radius, 0.0f)));
+        radius += 0.25f;
+    }
+
+    // Only the stamp that did not fit survives the clear
+    CHECK(cache.GetStampCount() == 1);
+}
+
+TEST(AllocatorPacksWithoutOverlap) {
+    AtlasAllocator allocator;
+    allocator.Reset(256, 256);
+
+    std::vector<StampRect> rects;
+    for (int i = 0; i < 200; ++i) {
+        StampRect rect;
+        if (!allocator.Allocate(8 + i % 13, 6 + i % 7, &rect)) break;
+        rects.push_back(rect);
+    }
+    CHECK(rects.size() > 100);
+
+    for (size_t i = 0; i < rects.size(); ++i) {
+        const StampRect& a = rects[i];
+        CHECK(a.x >= 0 && a.y >= 0 && a.x + a.width <= 256 && a.y + a.height <= 256);
+        for (size_t j = i + 1; j < rects.size(); ++j) {
+            const StampRect& b = rects[j];
+            bool overlap = a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+            CHECK(!overlap);
+        }
+    }
+}
+
+TEST(BlitTintsWithPremultipliedColor) {
+    StampCache cache;
+    const Stamp* stamp = cache.Find(StampCache::MakeKey(StampShape::SolidCircle, 6.0f, 6.0f, 0.0f));
+    REQUIRE(stamp);
+
+    const int size = 32;
+    std::vector<uint32_t> target(size * size, 0);
+
+    // Whole-pixel placement copies the coverage, tinted
+    BlitStamp(target.data(), size, size, size * sizeof(uint32_t), cache, *stamp, 16.0f, 16.0f, 0xFF0000FFu);
+    CHECK(target[16 * size + 16] == 0xFFFF0000u);
+
+    std::fill(target.begin(), target.end(), 0u);
+    BlitStamp(target.data(), size, size, size * sizeof(uint32_t), cache, *stamp, 16.0f, 16.0f, 0x0000FF80u);
+    CHECK(Alpha(target[16 * size + 16]) == 0x80);
+    CHECK(Blue(target[16 * size + 16]) == 0x80);
+    CHECK(Red(target[16 * size + 16]) == 0 && Green(target[16 * size + 16]) == 0);
+
+    // Fully transparent colors draw nothing
+    std::fill(target.begin(), target.end(), 0u);
+    BlitStamp(target.data(), size, size, size * sizeof(uint32_t), cache, *stamp, 16.0f, 16.0f, 0xFFFFFF00u);
+    bool empty = true;
+    for (uint32_t p : target) empty &= p == 0;
+    CHECK(empty);
+}
+
+TEST(BlitBlendsOverExistingContent) {
+    StampCache cache;
+    const Stamp* stamp = cache.Find(StampCache::MakeKey(StampShape::SolidCircle, 6.0f, 6.0f, 0.0f));
+    REQUIRE(stamp);
+
+    const int size = 32;
+    std::vector<uint32_t> target(size * size, 0xFF0000FFu); // Opaque blue
+    BlitStamp(target.data(), size, size, size * sizeof(uint32_t), cache, *stamp, 16.0f, 16.0f, 0xFF000080u);
+
+    // Half-transparent red over opaque blue
+    uint32_t p = target[16 * size + 16];
+    CHECK(Alpha(p) == 255);
+    CHECK(Red(p) >= 0x7F && Red(p) <= 0x81);
+    CHECK(Blue(p) >= 0x7E && Blue(p) <= 0x80);
+
+    // Outside the stamp nothing changes
+    CHECK(target[0] == 0xFF0000FFu);
+}
+
+TEST(SubPixelPlacementKeepsCoverage) {
+    StampCache cache;
+    const Stamp* stamp = cache.Find(StampCache::MakeKey(StampShape::SolidCircle, 6.0f, 6.0f, 0.0f));
+    REQUIRE(stamp);
+
+    const int size = 40;
+    auto total = [&](float x, float y) {
+        std::vector<uint32_t> target(size * size, 0);
+        BlitStamp(target.data(), size, size, size * sizeof(uint32_t), cache, *stamp, x, y, 0xFFFFFFFFu);
+        uint64_t sum = 0;
+        for (uint32_t p : target) sum += Alpha(p);
+        return (double)sum;
+    };
+
+    double whole = total(20.0f, 20.0f);
+    CHECK(whole > 0.0);
+    for (float offset : { 0.25f, 0.5f, 0.75f }) {
+        double moved = total(20.0f + offset, 20.0f + offset);
+        CHECK(moved > whole * 0.97 && moved < whole * 1.03);
+    }
+}
+
+TEST(BlitClipsToTheTarget) {
+    StampCache cache;
+    const Stamp* stamp = cache.Find(StampCache::MakeKey(StampShape::CornerBox, 20.0f, 12.0f, 2.0f));
+    REQUIRE(stamp);
+
+    // Guard columns on either side of a narrow target must stay untouched
+    const int width = 16, height = 8, stride = width + 2;
+    std::vector<uint32_t> buffer((size_t)stride * height, 0xDEADBEEFu);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 1; x <= width; ++x) buffer[(size_t)y * stride + x] = 0;
+    }
+
+    StampInstance instances[] = {
+        { stamp, -5.5f, -3.25f, 0xFFFFFFFFu },
+        { stamp, 15.5f, 7.75f, 0x00FF00FFu },
+        { nullptr, 8.0f, 4.0f, 0xFFFFFFFFu },
+    };
+    BlitStamps(buffer.data() + 1, width, height, stride * sizeof(uint32_t), cache, instances, 3);
+
+    bool guards = true;
+    for (int y = 0; y < height; ++y) {
+        guards &= buffer[(size_t)y * stride] == 0xDEADBEEFu && buffer[(size_t)y * stride + width + 1] == 0xDEADBEEFu;
+    }
+    CHECK(guards);
+}
+
+int main() {
+    return RunTests();
+}
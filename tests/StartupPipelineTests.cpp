@@ -0,0 +1,156 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "StartupPipeline.hpp"
+#include "TestHarness.hpp"
+
+using namespace std::chrono_literals;
+
+static const StartupPipeline::ReportEntry* FindEntry(const std::vector<StartupPipeline::ReportEntry>& report, const char* name) {
+    for (const StartupPipeline::ReportEntry& entry : report) {
+        if (entry.name == name) return &entry;
+    }
+    return nullptr;
+}
+
+TEST(RunsTasksAfterTheirDependencies) {
+    StartupPipeline pipeline;
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto record = [&](const char* name) {
+        return [&, name] {
+            std::this_thread::sleep_for(2ms);
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+            return true;
+        };
+    };
+
+    StartupPipeline::TaskId a = pipeline.AddTask("a", record("a"));
+    StartupPipeline::TaskId b = pipeline.AddTask("b", record("b"), { a });
+    StartupPipeline::TaskId c = pipeline.AddTask("c", record("c"), { a });
+    StartupPipeline::TaskId d = pipeline.AddTask("d", record("d"), { b, c });
+    pipeline.Start(4);
+
+    CHECK(pipeline.Wait(d));
+    CHECK(pipeline.Succeeded(a) && pipeline.Succeeded(b) && pipeline.Succeeded(c));
+    REQUIRE(order.size() == 4);
+    CHECK(order.front() == "a");
+    CHECK(order.back() == "d");
+}
+
+TEST(TasksAddedAfterStartRun) {
+    StartupPipeline pipeline;
+    pipeline.Start(2);
+
+    std::atomic<int> runs(0);
+    StartupPipeline::TaskId first = pipeline.AddTask("first", [&] { runs++; return true; });
+    StartupPipeline::TaskId second = pipeline.AddTask("second", [&] { runs++; return true; }, { first });
+    CHECK(pipeline.Wait(second));
+    CHECK(runs == 2);
+    CHECK(pipeline.IsDone(first));
+    CHECK(!pipeline.IsDone(1000));
+}
+
+TEST(FailurePropagatesToDependents) {
+    StartupPipeline pipeline;
+    std::atomic<bool> dependentRan(false);
+
+    StartupPipeline::TaskId failing = pipeline.AddTask("failing", [] { return false; });
+    StartupPipeline::TaskId dependent = pipeline.AddTask("dependent", [&] { dependentRan = true; return true; }, { failing });
+    StartupPipeline::TaskId unknown = pipeline.AddTask("unknown dependency", [] { return true; }, { 1000 });
+    pipeline.Start(2);
+
+    CHECK(!pipeline.Wait(dependent));
+    CHECK(!pipeline.Wait(unknown));
+    CHECK(!pipeline.Succeeded(failing));
+    CHECK(!dependentRan);
+
+    std::vector<StartupPipeline::ReportEntry> report = pipeline.GetReport();
+    const StartupPipeline::ReportEntry* entry = FindEntry(report, "dependent");
+    REQUIRE(entry);
+    CHECK(entry->background && !entry->succeeded);
+}
+
+// The overlay's device tasks rely on this: a dependent fails as soon as one dependency
+// fails, while a sibling dependency is still running, so waiting on the dependent alone
+// does not mean every task is done.
+TEST(DependentFailsWhileSiblingStillRuns) {
+    StartupPipeline pipeline;
+    std::atomic<bool> release(false);
+    std::atomic<bool> slowFinished(false);
+
+    StartupPipeline::TaskId slow = pipeline.AddTask("slow", [&] {
+        while (!release) std::this_thread::sleep_for(1ms);
+        slowFinished = true;
+        return true;
+    });
+    StartupPipeline::TaskId failing = pipeline.AddTask("failing", [] { return false; });
+    StartupPipeline::TaskId joined = pipeline.AddTask("joined", [] { return true; }, { slow, failing });
+    pipeline.Start(2);
+
+    CHECK(!pipeline.Wait(joined));
+    CHECK(!pipeline.IsDone(slow));
+
+    release = true;
+    CHECK(pipeline.Wait(slow));
+    CHECK(slowFinished);
+}
+
+TEST(StopDiscardsPendingTasks) {
+    std::atomic<bool> laterRan(false);
+    StartupPipeline pipeline;
+    pipeline.Start(1);
+
+    std::atomic<bool> started(false);
+    StartupPipeline::TaskId running = pipeline.AddTask("running", [&] {
+        started = true;
+        std::this_thread::sleep_for(20ms);
+        return true;
+    });
+    while (!started) std::this_thread::sleep_for(1ms);
+    StartupPipeline::TaskId later = pipeline.AddTask("later", [&] { laterRan = true; return true; }, { running });
+    pipeline.Stop();
+
+    CHECK(pipeline.Succeeded(running));
+    CHECK(!pipeline.Wait(later));
+    CHECK(!laterRan);
+}
+
+TEST(ReportsPhasesAndMilestonesFromOrigin) {
+    StartupPipeline pipeline(StartupPipeline::Clock::now() - 100ms);
+
+    size_t phase = pipeline.BeginPhase("window");
+    std::this_thread::sleep_for(5ms);
+    pipeline.EndPhase(phase, false);
+    size_t open = pipeline.BeginPhase("still open");
+    (void)open;
+    pipeline.MarkMilestone("first frame");
+
+    std::vector<StartupPipeline::ReportEntry> report = pipeline.GetReport();
+    REQUIRE(report.size() == 3);
+    for (size_t i = 1; i < report.size(); ++i) CHECK(report[i - 1].startMs <= report[i].startMs);
+
+    const StartupPipeline::ReportEntry* window = FindEntry(report, "window");
+    REQUIRE(window);
+    CHECK(window->startMs >= 100.0);
+    CHECK(window->durationMs >= 5.0);
+    CHECK(!window->succeeded && !window->background);
+    CHECK(FindEntry(report, "still open")->durationMs < 0.0);
+    CHECK(FindEntry(report, "first frame")->durationMs == 0.0);
+
+    std::ostringstream text;
+    pipeline.WriteReport(text);
+    CHECK(text.str().find("window") != std::string::npos);
+    CHECK(text.str().find("FAILED") != std::string::npos);
+    CHECK(text.str().find("total") != std::string::npos);
+}
+
+int main() {
+    return RunTests();
+}
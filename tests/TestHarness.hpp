@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdio>
+#include <vector>
+
+// Minimal test runner: TEST(name) registers a case, CHECK records a failure and carries
+// on, REQUIRE also returns from the case. RunTests() runs every case and returns the
+// process exit code.
+
+struct TestCase {
+    const char* name;
+    void (*function)();
+};
+
+inline std::vector<TestCase>& GetTestCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline int& GetTestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*function)()) {
+        GetTestCases().push_back({ name, function });
+    }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static TestRegistrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            GetTestFailures()++; \
+        } \
+    } while (0)
+
+#define REQUIRE(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: REQUIRE(%s) failed\n", __FILE__, __LINE__, #condition); \
+            GetTestFailures()++; \
+            return; \
+        } \
+    } while (0)
+
+inline int RunTests() {
+    for (const TestCase& test : GetTestCases()) {
+        int before = GetTestFailures();
+        test.function();
+        std::printf("%s %s\n", GetTestFailures() == before ? "[ OK ]  " : "[FAIL]  ", test.name);
+    }
+
+    std::printf("%zu tests, %d failed checks\n", GetTestCases().size(), GetTestFailures());
+    return GetTestFailures() ? 1 : 0;
+}
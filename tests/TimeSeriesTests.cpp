@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "TestHarness.hpp"
+#include "TimeSeries.hpp"
+
+// Decimation is checked against a plain scan of the same samples with the same column
+// boundaries as TimeSeriesPlot::Decimate.
+static void ExpectedEnvelope(const std::vector<float>& history, size_t sampleCount, size_t columns,
+    std::vector<float>& mins, std::vector<float>& maxs) {
+    size_t count = (std::min)(sampleCount, history.size());
+    size_t start = history.size() - count;
+    mins.assign(columns, 0.0f);
+    maxs.assign(columns, 0.0f);
+
+    for (size_t column = 0; column < columns; ++column) {
+        size_t begin = start + (size_t)((double)column * count / columns);
+        size_t end = start + (size_t)((double)(column + 1) * count / columns);
+        if (end <= begin) end = begin + 1;
+
+        mins[column] = *std::min_element(history.begin() + begin, history.begin() + end);
+        maxs[column] = *std::max_element(history.begin() + begin, history.begin() + end);
+    }
+}
+
+static bool EnvelopeMatches(const TimeSeriesPlot& plot, const std::vector<float>& history, size_t sampleCount, size_t columns) {
+    std::vector<float> mins(columns), maxs(columns), expectedMins, expectedMaxs;
+    if (!plot.Decimate(sampleCount, columns, mins.data(), maxs.data())) return false;
+
+    ExpectedEnvelope(history, sampleCount, columns, expectedMins, expectedMaxs);
+    return mins == expectedMins && maxs == expectedMaxs;
+}
+
+TEST(DecimateMatchesBruteForce) {
+    std::mt19937 random(11);
+    std::normal_distribution<float> noise(10.0f, 4.0f);
+
+    TimeSeriesPlot plot(4096);
+    std::vector<float> history;
+
+    // Several laps, so blocks restart and runs wrap around the end of the ring
+    for (int round = 0; round < 40; ++round) {
+        int batch = 1 + (int)(random() % 700);
+        for (int i = 0; i < batch; ++i) {
+            float value = noise(random);
+            if (random() % 97 == 0) value *= 20.0f; // Spikes the envelope must not lose
+            plot.Push(value);
+            history.push_back(value);
+        }
+        plot.Update();
+        CHECK(plot.GetCount() == (std::min)(history.size(), (size_t)4096));
+
+        for (size_t sampleCount : { (size_t)1, (size_t)31, (size_t)33, (size_t)1000, (size_t)1024, (size_t)3000, (size_t)4096 }) {
+            for (size_t columns : { (size_t)1, (size_t)7, (size_t)300, (size_t)1920 }) {
+                CHECK(EnvelopeMatches(plot, history, sampleCount, columns));
+            }
+        }
+    }
+}
+
+TEST(FewerSamplesThanColumnsRepeatSamples) {
+    TimeSeriesPlot plot(64);
+    plot.Push(1.0f);
+    plot.Push(5.0f);
+    plot.Push(3.0f);
+    plot.Update();
+
+    float mins[6], maxs[6];
+    CHECK(plot.Decimate(100, 6, mins, maxs));
+    const float expected[6] = { 1.0f, 1.0f, 5.0f, 5.0f, 3.0f, 3.0f };
+    for (int i = 0; i < 6; ++i) {
+        CHECK(mins[i] == expected[i]);
+        CHECK(maxs[i] == expected[i]);
+    }
+}
+
+TEST(EmptyPlotHasNothingToDraw) {
+    TimeSeriesPlot plot(64);
+    float minValue, maxValue;
+    CHECK(!plot.Decimate(100, 10, &minValue, &maxValue));
+    CHECK(!plot.GetRange(100, &minValue, &maxValue));
+
+    plot.Push(2.0f);
+    plot.Update();
+    CHECK(!plot.Decimate(100, 0, &minValue, &maxValue));
+    CHECK(plot.GetRange(100, &minValue, &maxValue));
+    CHECK(minValue == 2.0f && maxValue == 2.0f);
+    CHECK(plot.GetLatest() == 2.0f);
+}
+
+TEST(GetRangeCoversTheNewestSamples) {
+    TimeSeriesPlot plot(1024);
+    for (int i = 0; i < 5000; ++i) plot.Push((float)(i % 1000));
+    plot.Update();
+
+    // The newest 1024 samples are 3976..4999, i.e. values 976..999 and 0..999
+    float minValue, maxValue;
+    CHECK(plot.GetRange(1024, &minValue, &maxValue));
+    CHECK(minValue == 0.0f && maxValue == 999.0f);
+
+    CHECK(plot.GetRange(24, &minValue, &maxValue));
+    CHECK(minValue == 976.0f && maxValue == 999.0f);
+}
+
+TEST(FallingALapBehindKeepsTheNewestLap) {
+    TimeSeriesPlot plot(256);
+    std::vector<float> history;
+    for (int i = 0; i < 1000; ++i) {
+        plot.Push((float)i);
+        history.push_back((float)i);
+    }
+
+    // The first 744 samples were overwritten before Update ran
+    plot.Update();
+    CHECK(plot.GetCount() == 256);
+    CHECK(plot.GetLatest() == 999.0f);
+    CHECK(EnvelopeMatches(plot, history, 256, 256));
+    CHECK(EnvelopeMatches(plot, history, 256, 5));
+}
+
+TEST(RingReportsPendingAndLostSlots) {
+    TimeSeriesRing ring(4);
+    float value = 0.0f;
+    CHECK(ring.Read(0, &value) == TimeSeriesRing::ReadResult::Pending);
+
+    ring.Push(1.0f);
+    CHECK(ring.Read(0, &value) == TimeSeriesRing::ReadResult::Ready);
+    CHECK(value == 1.0f);
+    CHECK(ring.Read(1, &value) == TimeSeriesRing::ReadResult::Pending);
+
+    for (int i = 0; i < 4; ++i) ring.Push(2.0f + i);
+    CHECK(ring.Read(0, &value) == TimeSeriesRing::ReadResult::Lost);
+    CHECK(ring.Read(4, &value) == TimeSeriesRing::ReadResult::Ready);
+    CHECK(value == 5.0f);
+
+    CHECK(TimeSeriesRing::RoundUpPow2(1) == 1);
+    CHECK(TimeSeriesRing::RoundUpPow2(5) == 8);
+    CHECK(ring.GetCapacity() == 4);
+}
+
+TEST(MinMaxRunMatchesScalar) {
+    std::mt19937 random(12);
+    std::uniform_real_distribution<float> values(-1000.0f, 1000.0f);
+
+    for (size_t count = 0; count < 70; ++count) {
+        std::vector<float> mins(count), maxs(count);
+        for (size_t i = 0; i < count; ++i) {
+            mins[i] = values(random);
+            maxs[i] = mins[i] + 1.0f;
+        }
+
+        float low = 5000.0f, high = -5000.0f;
+        TimeSeriesPlot::MinMaxRun(mins.data(), maxs.data(), count, &low, &high);
+
+        float expectedLow = 5000.0f, expectedHigh = -5000.0f;
+        for (size_t i = 0; i < count; ++i) {
+            expectedLow = (std::min)(expectedLow, mins[i]);
+            expectedHigh = (std::max)(expectedHigh, maxs[i]);
+        }
+        CHECK(low == expectedLow);
+        CHECK(high == expectedHigh);
+    }
+}
+
+TEST(ConcurrentProducersLoseNothingWithinALap) {
+    const int producers = 4, perProducer = 20000;
+    TimeSeriesPlot plot(producers * perProducer);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&plot, p] {
+            for (int i = 0; i < perProducer; ++i) plot.Push((float)(p * perProducer + i));
+        });
+    }
+
+    // Consume while producers run; pending slots are picked up on a later call
+    for (int i = 0; i < 100; ++i) plot.Update();
+    for (std::thread& thread : threads) thread.join();
+    plot.Update();
+
+    CHECK(plot.GetCount() == (size_t)(producers * perProducer));
+
+    // Every value arrives exactly once, in some interleaving
+    std::vector<float> mins(producers * perProducer), maxs(producers * perProducer);
+    REQUIRE(plot.Decimate(mins.size(), mins.size(), mins.data(), maxs.data()));
+    std::sort(mins.begin(), mins.end());
+    for (size_t i = 0; i < mins.size(); ++i) CHECK(mins[i] == (float)i);
+}
+
+int main() {
+    return RunTests();
+}